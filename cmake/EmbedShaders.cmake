@@ -0,0 +1,35 @@
+# Generates a header holding shader sources as constexpr string_views, run
+# in script mode by the compile_executable macro:
+#   cmake -DOUTPUT=<header> -DBASE_DIR=<src dir> -DFILES=<a.sd|b.sd> -P
+# Each file is registered under its path relative to BASE_DIR, which is
+# what ShaderPreprocessor resolves #includes against.
+
+string(REPLACE "|" ";" FILES "${FILES}")
+
+set(content "// generated by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND content "#pragma once\n#include \"common/EmbeddedShaders.h\"\n")
+string(APPEND content "#include <array>\n#include <string_view>\n\n")
+string(APPEND content "namespace embedded_shaders {\n")
+
+set(entries "")
+set(count 0)
+foreach(file IN LISTS FILES)
+  file(RELATIVE_PATH path "${BASE_DIR}" "${file}")
+  file(READ "${file}" source)
+  if(source MATCHES "\\)sd\"")
+    message(FATAL_ERROR "${file} contains the raw string delimiter )sd\"")
+  endif()
+  string(MAKE_C_IDENTIFIER "${path}" name)
+  string(APPEND content
+         "inline constexpr std::string_view ${name} = R\"sd(${source})sd\";\n")
+  string(APPEND entries "    EmbeddedFile{\"${path}\", ${name}},\n")
+  math(EXPR count "${count} + 1")
+endforeach()
+
+string(APPEND content "\ninline constexpr std::array<EmbeddedFile, ${count}> FILES{{\n")
+string(APPEND content "${entries}}};\n} // namespace embedded_shaders\n")
+
+# leave the file untouched when nothing changed so dependents don't rebuild
+file(WRITE "${OUTPUT}.tmp" "${content}")
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
@@ -1,3 +1,5 @@
+#include "common/EmbeddedShaders.h"
+#include "embedded_shaders.h"
 #include "previous_code.cpp"
 #include <cmath>
 #include <glm/fwd.hpp>
@@ -13,16 +15,18 @@ int main() {
     glEnable(GL_DEPTH_TEST);
   }
 
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
   Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
-  unsigned int texture_floor, texture_wall;
+  Texture2D texture_floor, texture_wall;
   unsigned int VAO;
   { // prepare data
     VAO = create_vao();
     auto EBO = create_ebo(VAO);
 
     // Prepare Texture data
-    texture_floor = create_texture(TEXTURE_PATH_FLOOR.c_str());
-    texture_wall = create_texture(TEXTURE_PATH_WALL.c_str());
+    texture_floor = Texture2D{TEXTURE_PATH_FLOOR};
+    texture_wall = Texture2D{TEXTURE_PATH_WALL};
 
     // draw our first triangle
     shader.use();
@@ -71,9 +75,9 @@ int main() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glBindVertexArray(VAO);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_floor);
+    texture_floor.bind();
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture_wall);
+    texture_wall.bind();
 
     const float radius = 10.0f;
 
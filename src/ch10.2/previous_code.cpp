@@ -5,9 +5,8 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/trigonometric.hpp>
 #include <iostream>
-#define STB_IMAGE_IMPLEMENTATION
+#include "common/Texture2D.h"
 #include "common/shader.h"
-#include "stb_image.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -19,15 +18,15 @@
 #include <thread>
 #include <vector>
 
-const std::string PROJ_DIR = "/home/lenty/scripts/cpp/opengl/";
 const std::string SUB_DIR = "ch10.2";
 
-const std::string VERTEX_SRC = PROJ_DIR + "src/" + SUB_DIR + "/vertex.sd";
+// paths of the embedded shaders, relative to src/
+const std::string VERTEX_SRC = SUB_DIR + "/vertex.sd";
 
-const std::string FRAGMENT_SRC = PROJ_DIR + "src/" + SUB_DIR + "/fragment.sd";
+const std::string FRAGMENT_SRC = SUB_DIR + "/fragment.sd";
 
-const std::string TEXTURE_PATH_FLOOR = PROJ_DIR + "assets/floor.jpg";
-const std::string TEXTURE_PATH_WALL = PROJ_DIR + "assets/wall.jpg";
+const std::string TEXTURE_PATH_FLOOR = assetPath("floor.jpg");
+const std::string TEXTURE_PATH_WALL = assetPath("wall.jpg");
 
 std::vector<unsigned int> vbos{};
 std::vector<unsigned int> vaos{};
@@ -194,34 +193,3 @@ void clean_buffer() {
     ebos.pop_back();
   }
 }
-
-unsigned int create_texture(const char *texture_path) {
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  // set the texture wrapping/filtering options (on currently bound texture)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  int image_w, image_h, image_nCh;
-  stbi_set_flip_vertically_on_load(true);
-  unsigned char *image_data =
-      stbi_load(texture_path, &image_w, &image_h, &image_nCh, 0);
-
-  if (image_data) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, image_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  } else {
-    std::cout << "Failed to load texture" << std::endl;
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, image_data);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  stbi_image_free(image_data);
-  return texture;
-}
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "common/Camera.h"
+#include "common/EmbeddedShaders.h"
+#include "common/TextureCache.h"
+#include "common/UniformBlock.h"
+#include "embedded_shaders.h"
 #include "previous_code.cpp"
 #include <GLFW/glfw3.h>
 #include <cmath>
@@ -41,15 +45,28 @@ int main() {
   glfwSetMouseButtonCallback(window, on_mouse_click);
   glfwSetScrollCallback(window, scroll_callback);
 
-  Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
-  unsigned int texture_floor, texture_wall;
+  // all cubes are drawn as instances of one draw call, their transforms
+  // live in the Objects uniform block
+  constexpr size_t CUBE_COUNT = 10;
+  struct Objects {
+    glm::mat4 model[CUBE_COUNT];
+  };
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
+  Shader shader{VERTEX_SRC.c_str(),
+                FRAGMENT_SRC.c_str(),
+                {{"CUBE_COUNT", std::to_string(CUBE_COUNT)}}};
+  UniformBlock<Objects> objects{"Objects", 1};
+  objects.attach(shader);
+  std::shared_ptr<Texture2D> texture_floor, texture_wall;
   unsigned int VAO;
   { // prepare data
     VAO = create_vao();
 
     // Prepare Texture data
-    texture_floor = create_texture(TEXTURE_PATH_FLOOR.c_str());
-    texture_wall = create_texture(TEXTURE_PATH_WALL.c_str());
+    // decoded and uploaded once per process, later requests share them
+    texture_floor = TextureCache::get(TEXTURE_PATH_FLOOR);
+    texture_wall = TextureCache::get(TEXTURE_PATH_WALL);
 
     // draw our first triangle
     shader.use();
@@ -60,8 +77,12 @@ int main() {
     shader.setInt("texture2_percent", 1.0f);
   }
 
+  // Resolve uniforms once, the loop only passes handles
+  auto viewLoc = shader.getUniformHandle("view");
+  auto projectionLoc = shader.getUniformHandle("projection");
+
   // Model positions
-  glm::vec3 cubePositions[] = {
+  glm::vec3 cubePositions[CUBE_COUNT] = {
       glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
       glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
       glm::vec3(2.4f, -0.4f, -3.5f),  glm::vec3(-1.7f, 3.0f, -7.5f),
@@ -98,9 +119,9 @@ int main() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glBindVertexArray(VAO);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_floor);
+    texture_floor->bind();
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture_wall);
+    texture_wall->bind();
 
     glm::mat4 view, projection;
 
@@ -112,7 +133,8 @@ int main() {
                                       static_cast<float>(SCR_HEIGHT),
                                   0.1f, 100.0f);
 
-    for (size_t i = 0; i < 10; ++i) {
+    Objects batch;
+    for (size_t i = 0; i < CUBE_COUNT; ++i) {
       glm::mat4 model = glm::mat4(1.0f);
       model = glm::translate(model, cubePositions[i]);
 
@@ -122,19 +144,14 @@ int main() {
       float angle = 20.0f * i;
       model =
           glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-
-      // Pass value to shader
-      int modelLoc = glGetUniformLocation(shader.getProgramId(), "model");
-      glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-      int viewLoc = glGetUniformLocation(shader.getProgramId(), "view");
-      glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-      int projectionLoc =
-          glGetUniformLocation(shader.getProgramId(), "projection");
-      glUniformMatrix4fv(projectionLoc, 1, GL_FALSE,
-                         glm::value_ptr(projection));
-
-      glDrawArrays(GL_TRIANGLES, 0, 36);
+      batch.model[i] = model;
     }
+
+    // Pass value to shader, one block upload for every cube
+    objects.update(batch);
+    shader.setMat4f(viewLoc, view);
+    shader.setMat4f(projectionLoc, projection);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, CUBE_COUNT);
     // glBindVertexArray(0); // no need to unbind it every time
 
     // Check and call events and swap buffers
@@ -157,6 +174,9 @@ int main() {
   }
 
   clean_buffer();
+  texture_floor.reset();
+  texture_wall.reset();
+  TextureCache::clear();
   // Close
   glfwTerminate();
 
@@ -1,7 +1,17 @@
 #include "common/Camera.h"
+#include "common/DrawUniforms.h"
+#include "common/EmbeddedShaders.h"
+#include "common/FrameUniforms.h"
+#include "common/ProgramPipeline.h"
+#include "common/ShaderVariants.h"
+#include "common/ShaderWatcher.h"
+#include "common/UniformRing.h"
+#include "common/Uniform.h"
 #include "common/shader.h"
+#include "embedded_shaders.h"
 #include "previous_code.cpp"
 #include <cmath>
+#include <cstdlib>
 #include <glm/fwd.hpp>
 
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
@@ -24,8 +34,8 @@ float deltaTime = 0.0f; // time between current frame and last frame
 float lastFrame = 0.0f;
 
 unsigned int lightVAO;
-const std::string LIGHT_FRAGMENT_SRC =
-    PROJ_DIR + "src/" + SUB_DIR + "/light_fragment.sd";
+// uniform set every frame, name hashed at compile time
+const Uniform<glm::vec3> LIGHT_COLOR{"lightColor"};
 
 unsigned int create_light_VAO(unsigned int vbo) {
   unsigned int lightVAO;
@@ -59,26 +69,52 @@ int main() {
   glfwSetMouseButtonCallback(window, on_mouse_click);
   glfwSetScrollCallback(window, scroll_callback);
 
-  // Prepare Shader data
-  Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
-  shader.use();
+  // Prepare Shader data, both programs compile while the buffers are set up.
+  // The light cube is the LIGHT_CUBE variant of the same sources, which are
+  // compiled into the executable (set SHADER_SOURCE_DIR to edit them live).
+  EmbeddedShaders::add(embedded_shaders::FILES);
+  // By default both cubes are linked variants of one Shader, which are
+  // validated, hot reloaded and counted in the statistics below. With
+  // SHADER_PIPELINES set and separate shader objects available they share
+  // one compiled vertex stage instead and only the fragment stages differ.
+  ShaderVariants shaders{VERTEX_SRC, FRAGMENT_SRC};
+  // flat colored stand-in for programs that are still compiling; submitted
+  // first so it is linked long before the others
+  Shader *placeholder = &shaders.get({{"PLACEHOLDER", ""}});
+  std::unique_ptr<ProgramPipeline> object_pipeline, light_pipeline;
+  Shader *shader = nullptr, *light_cube_shader = nullptr;
+  bool use_pipelines = std::getenv("SHADER_PIPELINES") != nullptr;
+  if (use_pipelines && !ProgramPipeline::supported()) {
+    std::cout << "SHADER_PIPELINES ignored, separate shader objects are "
+                 "not supported"
+              << std::endl;
+    use_pipelines = false;
+  }
+  if (use_pipelines) {
+    object_pipeline = std::make_unique<ProgramPipeline>(VERTEX_SRC.c_str(),
+                                                        FRAGMENT_SRC.c_str());
+    light_pipeline = std::make_unique<ProgramPipeline>(
+        VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str(), ShaderDefines{},
+        ShaderDefines{{"LIGHT_CUBE", ""}});
+    std::cout << "program pipelines, " << StageCache::size()
+              << " stages for 2 programs" << std::endl;
+  } else {
+    shader = &shaders.get();
+    light_cube_shader = &shaders.get({{"LIGHT_CUBE", ""}});
+    // edits below SHADER_SOURCE_DIR are picked up while running
+    if (!EmbeddedShaders::getSourceDirectory().empty())
+      ShaderWatcher::start();
+  }
 
   unsigned int VAO;
   { // prepare Vertex data
     VAO = create_vao();
-    shader.use();
   }
 
-  Shader light_cube_shader{VERTEX_SRC.c_str(), LIGHT_FRAGMENT_SRC.c_str()};
-
-  glm::mat4 view, projection;
-  view =
-      glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
-
-  projection = glm::perspective(glm::radians(camera.Zoom),
-                                static_cast<float>(SCR_WIDTH) /
-                                    static_cast<float>(SCR_HEIGHT),
-                                0.1f, 100.0f);
+  // view/projection shared by both programs, uploaded once per frame
+  FrameUniforms frame_uniforms;
+  // model matrix and color of both cubes, one ring slice per frame
+  UniformRing draw_ring{sizeof(DrawUniformsData), 2};
 
   glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
   auto light_model = glm::mat4(1.0f);
@@ -99,11 +135,36 @@ int main() {
 
   glm::vec3 lightColor{1.0f, 1.0f, 1.0f};
 
+  // waits for the placeholder only, the other programs keep compiling
+  placeholder->validateVertexArray(VAO);
+  // the lit programs are checked once both have linked, see the loop
+  bool programs_checked = shader == nullptr;
+
+  // nothing pops in: a cube whose program is still being compiled (or
+  // failed to build) is drawn flat with the placeholder meanwhile
+  auto draw_cube = [&](ProgramPipeline *pipeline, Shader *program,
+                       const UniformRing::Range &range, unsigned int vao) {
+    if (pipeline && pipeline->isReady()) {
+      pipeline->use();
+      pipeline->set(LIGHT_COLOR, lightColor);
+    } else if (program && program->isReady()) {
+      program->use();
+      program->set(LIGHT_COLOR, lightColor);
+    } else {
+      placeholder->use();
+    }
+    draw_ring.bind(range, DrawUniforms::BINDING_POINT);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+  };
+
   std::cout << "press [Esc] to close the window" << std::endl;
   while (!glfwWindowShouldClose(window)) {
     float currentFrame = static_cast<float>(glfwGetTime());
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
+    ShaderWatcher::poll();
 
     // [process input]
     processInput(window);
@@ -115,40 +176,29 @@ int main() {
     // This has to be run before rendering, it will clean the z Depth buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    view = camera.GetViewMatrix();
-
-    projection = glm::perspective(glm::radians(camera.Zoom),
-                                  static_cast<float>(SCR_WIDTH) /
-                                      static_cast<float>(SCR_HEIGHT),
-                                  0.1f, 100.0f);
-
-    { // Draw object
-      shader.use();
-      glm::mat4 model = glm::mat4(1.0f);
-      model = glm::rotate(model, theta, glm::vec3(0.5f, 1.0f, 0.0f));
-
-      // Pass value to shader
-      shader.setMat4f("model", model);
-      shader.setMat4f("view", view);
-      shader.setMat4f("projection", projection);
-      shader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
-      shader.setVec3("lightColor", lightColor);
-      glBindVertexArray(VAO);
-      glDrawArrays(GL_TRIANGLES, 0, 36);
-      glBindVertexArray(0);
-      shader.disable();
-    }
-
-    { // Draw Light cube
-      light_cube_shader.use();
-      light_cube_shader.setMat4f("model", light_model);
-      light_cube_shader.setMat4f("view", view);
-      light_cube_shader.setMat4f("projection", projection);
-      light_cube_shader.setVec3("lightColor", lightColor);
-      glBindVertexArray(lightVAO);
-      glDrawArrays(GL_TRIANGLES, 0, 36);
-      glBindVertexArray(0);
-      light_cube_shader.disable();
+    frame_uniforms.update(camera, static_cast<float>(SCR_WIDTH) /
+                                      static_cast<float>(SCR_HEIGHT));
+
+    // per-draw constants are written up front and bound by offset
+    draw_ring.beginFrame();
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::rotate(model, theta, glm::vec3(0.5f, 1.0f, 0.0f));
+    auto object_draw = draw_ring.allocate(
+        DrawUniformsData{model, glm::vec4(1.0f, 0.5f, 0.31f, 1.0f)});
+    auto light_draw = draw_ring.allocate(
+        DrawUniformsData{light_model, glm::vec4(lightColor, 1.0f)});
+    draw_ring.upload();
+
+    draw_cube(object_pipeline.get(), shader, object_draw, VAO);
+    draw_cube(light_pipeline.get(), light_cube_shader, light_draw, lightVAO);
+    draw_ring.endFrame();
+    if (!programs_checked && shader->isReady() &&
+        light_cube_shader->isReady()) {
+      // make sure the vertex arrays match the shader inputs
+      shader->validateVertexArray(VAO);
+      light_cube_shader->validateVertexArray(lightVAO);
+      Shader::printBuildReport();
+      programs_checked = true;
     }
     // Check and call events and swap buffers
     glfwSwapBuffers(window);
@@ -161,7 +211,26 @@ int main() {
       time_sum += deltaTime;      
       ++count;
       if (count > 100) {
-        std::cout << "FPS: " << count / time_sum << std::endl;
+        std::cout << "FPS: " << count / time_sum;
+        // pipelines are bound and fed outside of Shader's counters
+        if (shader) {
+          auto binds = Shader::getBindStats();
+          auto uploads = Shader::getUploadStats();
+          std::cout << " program binds/frame: "
+                    << static_cast<float>(binds.issued) / count
+                    << " elided/frame: "
+                    << static_cast<float>(binds.elided) / count
+                    << "\nuniform uploads/frame: "
+                    << static_cast<float>(uploads.issued) / count
+                    << " skipped/frame: "
+                    << static_cast<float>(uploads.skipped) / count;
+        }
+        std::cout << std::endl;
+        std::cout << "uniform ring stalls: " << draw_ring.getStats().waits
+                  << std::endl;
+        draw_ring.resetStats();
+        Shader::resetBindStats();
+        Shader::resetUploadStats();
         time_sum = 0.0f;
         count = 0.0f;
       }
@@ -170,6 +239,7 @@ int main() {
 
   clean_buffer();
   // Close
+  ShaderWatcher::stop();
   glfwTerminate();
 
   return 0;
@@ -1,5 +1,7 @@
 #include "glad/glad.h"
+#include "common/EmbeddedShaders.h"
 #include "common/shader.h"
+#include "embedded_shaders.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -10,10 +12,9 @@
 #include <sstream>
 #include <vector>
 
-constexpr const char *FRAGMENT_SRC =
-    "/home/lenty/scripts/cpp/opengl/src/ch6.3/fragement.sd";
-constexpr const char *VERTEX_SRC =
-    "/home/lenty/scripts/cpp/opengl/src/ch6.3/vertex.sd";
+// paths of the embedded shaders, relative to src/
+constexpr const char *FRAGMENT_SRC = "ch6.3/fragement.sd";
+constexpr const char *VERTEX_SRC = "ch6.3/vertex.sd";
 
 std::vector<unsigned int> vbos{};
 std::vector<unsigned int> vaos{};
@@ -136,6 +137,8 @@ int main() {
 
   load_glad();
 
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
   Shader shader{VERTEX_SRC, FRAGMENT_SRC};
 
   // prepare data
@@ -1,5 +1,7 @@
 #include "glad/glad.h"
+#include "common/EmbeddedShaders.h"
 #include "common/shader.h"
+#include "embedded_shaders.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -10,11 +12,10 @@
 #include <sstream>
 #include <vector>
 
-constexpr const char *VERTEX_SRC =
-    "/home/lenty/scripts/cpp/opengl/src/ch6.3_ex3/vertex.sd";
+// paths of the embedded shaders, relative to src/
+constexpr const char *VERTEX_SRC = "ch6.3_ex3/vertex.sd";
 
-constexpr const char *FRAGMENT_SRC =
-    "/home/lenty/scripts/cpp/opengl/src/ch6.3_ex3/fragement.sd";
+constexpr const char *FRAGMENT_SRC = "ch6.3_ex3/fragement.sd";
 
 std::vector<unsigned int> vbos{};
 std::vector<unsigned int> vaos{};
@@ -137,6 +138,8 @@ int main() {
 
   load_glad();
 
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
   Shader shader{VERTEX_SRC, FRAGMENT_SRC};
 
   // prepare data
@@ -1,7 +1,8 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "glad/glad.h"
+#include "common/EmbeddedShaders.h"
+#include "common/Texture2D.h"
 #include "common/shader.h"
-#include "stb_image.h"
+#include "embedded_shaders.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -12,14 +13,12 @@
 #include <sstream>
 #include <vector>
 
-const std::string PROJ_DIR = "/home/lenty/scripts/cpp/opengl/";
+// paths of the embedded shaders, relative to src/
+const std::string VERTEX_SRC = "ch7.1/vertex.sd";
 
-const std::string VERTEX_SRC = PROJ_DIR + "src/ch7.1/vertex.sd";
+const std::string FRAGMENT_SRC = "ch7.1/fragment.sd";
 
-const std::string FRAGMENT_SRC = PROJ_DIR + "src/ch7.1/fragment.sd";
-
-const std::string TEXTURE_PATH_FLOOR = PROJ_DIR + "assets/floor.png";
-const std::string TEXTURE_PATH_WALL = PROJ_DIR + "assets/wall.jpg";
+const std::string TEXTURE_PATH_FLOOR = assetPath("floor.jpg");
 
 std::vector<unsigned int> vbos{};
 std::vector<unsigned int> vaos{};
@@ -145,6 +144,8 @@ int main() {
   auto window = create_window();
   load_glad();
 
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
   Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
 
   // prepare data
@@ -154,41 +155,7 @@ int main() {
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
   // Prepare Texture data
-
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  // set the texture wrapping/filtering options (on currently bound texture)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  int floor_texture_w, floor_texture_h, floor_texture_nCh;
-  stbi_set_flip_vertically_on_load(true);
-  unsigned char *texture_data_floor =
-      stbi_load(TEXTURE_PATH_FLOOR.c_str(), &floor_texture_w, &floor_texture_h,
-                &floor_texture_nCh, 0);
-
-  if (texture_data_floor) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, floor_texture_w, floor_texture_h, 0,
-                 GL_RGB, GL_UNSIGNED_BYTE, texture_data_floor);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  } else {
-    std::cout << "Failed to load texture" << std::endl;
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, floor_texture_w, floor_texture_h, 0,
-               GL_RGB, GL_UNSIGNED_BYTE, texture_data_floor);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  stbi_image_free(texture_data_floor);
-
-  int wall_texture_w, wall_texture_h, wall_texture_nCh;
-
-  unsigned char *texture_data_wall =
-      stbi_load(TEXTURE_PATH_WALL.c_str(), &wall_texture_w, &wall_texture_h,
-                &wall_texture_nCh, 0);
+  Texture2D texture{TEXTURE_PATH_FLOOR};
 
   std::cout << "press [Esc] to close the window" << std::endl;
   float theta = 0;
@@ -201,8 +168,7 @@ int main() {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    glActiveTexture(GL_TEXTURE0); // activate texture unit first
-    glBindTexture(GL_TEXTURE_2D, texture);
+    texture.bind(0);
 
     // draw our first triangle
     shader.use();
@@ -4,10 +4,11 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/trigonometric.hpp>
 #include <iostream>
-#define STB_IMAGE_IMPLEMENTATION
 #include "glad/glad.h"
+#include "common/EmbeddedShaders.h"
+#include "common/Texture2D.h"
 #include "common/shader.h"
-#include "stb_image.h"
+#include "embedded_shaders.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -19,14 +20,13 @@
 #include <thread>
 #include <vector>
 
-const std::string PROJ_DIR = "/home/lenty/scripts/cpp/opengl/";
+// paths of the embedded shaders, relative to src/
+const std::string VERTEX_SRC = "ch8.17/vertex.sd";
 
-const std::string VERTEX_SRC = PROJ_DIR + "src/ch8.17/vertex.sd";
+const std::string FRAGMENT_SRC = "ch8.17/fragment.sd";
 
-const std::string FRAGMENT_SRC = PROJ_DIR + "src/ch8.17/fragment.sd";
-
-const std::string TEXTURE_PATH_FLOOR = PROJ_DIR + "assets/floor.jpg";
-const std::string TEXTURE_PATH_WALL = PROJ_DIR + "assets/wall.jpg";
+const std::string TEXTURE_PATH_FLOOR = assetPath("floor.jpg");
+const std::string TEXTURE_PATH_WALL = assetPath("wall.jpg");
 
 
 std::vector<unsigned int> vbos{};
@@ -147,43 +147,14 @@ void clean_buffer() {
   }
 }
 
-unsigned int create_texture(const char *texture_path) {
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  // set the texture wrapping/filtering options (on currently bound texture)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  int image_w, image_h, image_nCh;
-  stbi_set_flip_vertically_on_load(true);
-  unsigned char *image_data =
-      stbi_load(texture_path, &image_w, &image_h, &image_nCh, 0);
-
-  if (image_data) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, image_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  } else {
-    std::cout << "Failed to load texture" << std::endl;
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, image_data);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  stbi_image_free(image_data);
-  return texture;
-}
-
 int main() {
 
   init_glfw();
   auto window = create_window();
   load_glad();
 
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
   Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
 
   // prepare data
@@ -193,8 +164,8 @@ int main() {
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
   // Prepare Texture data
-  unsigned int texture_floor = create_texture(TEXTURE_PATH_FLOOR.c_str());
-  unsigned int texture_wall = create_texture(TEXTURE_PATH_WALL.c_str());
+  Texture2D texture_floor{TEXTURE_PATH_FLOOR};
+  Texture2D texture_wall{TEXTURE_PATH_WALL};
 
   // draw our first triangle
   shader.use();
@@ -236,10 +207,10 @@ int main() {
     glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(trans));
 
     glActiveTexture(GL_TEXTURE0); // activate texture unit first
-    glBindTexture(GL_TEXTURE_2D, texture_floor);
+    texture_floor.bind();
 
     glActiveTexture(GL_TEXTURE1); // activate texture unit first
-    glBindTexture(GL_TEXTURE_2D, texture_wall);
+    texture_wall.bind();
 
     glBindVertexArray(VAO);
 
@@ -4,9 +4,12 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/trigonometric.hpp>
 #include <iostream>
-#define STB_IMAGE_IMPLEMENTATION
+#include "common/EmbeddedShaders.h"
+#include "common/SpecializedShader.h"
+#include "common/Texture2D.h"
+#include "common/Uniform.h"
 #include "common/shader.h"
-#include "stb_image.h"
+#include "embedded_shaders.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -18,23 +21,40 @@
 #include <thread>
 #include <vector>
 
-const std::string PROJ_DIR = "/home/lenty/scripts/cpp/opengl/";
 const std::string SUB_DIR = "ch9.8";
 
-const std::string VERTEX_SRC = PROJ_DIR + "src/" + SUB_DIR + "/vertex.sd";
+// paths of the embedded shaders, relative to src/
+const std::string VERTEX_SRC = SUB_DIR + "/vertex.sd";
 
-const std::string FRAGMENT_SRC = PROJ_DIR + "src/" + SUB_DIR + "/fragment.sd";
+const std::string FRAGMENT_SRC = SUB_DIR + "/fragment.sd";
 
-const std::string TEXTURE_PATH_FLOOR = PROJ_DIR + "assets/floor.jpg";
-const std::string TEXTURE_PATH_WALL = PROJ_DIR + "assets/wall.jpg";
+const std::string TEXTURE_PATH_FLOOR = assetPath("floor.jpg");
+const std::string TEXTURE_PATH_WALL = assetPath("wall.jpg");
 
 std::vector<unsigned int> vbos{};
 std::vector<unsigned int> vaos{};
 std::vector<unsigned int> ebos{};
 
+// texture mix factor, compiled into the fragment shader as a constant
+float mix_factor = 0.7f;
+
 void processInput(GLFWwindow *window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
+  // one step of 0.1 per key press keeps the number of specialized programs
+  // small; a held key would otherwise build one each frame
+  static bool up_held = false;
+  static bool down_held = false;
+  bool up = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+  bool down = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+  int step = static_cast<int>(std::round(mix_factor * 10.0f));
+  if (up && !up_held)
+    step = std::min(step + 1, 10);
+  if (down && !down_held)
+    step = std::max(step - 1, 0);
+  up_held = up;
+  down_held = down;
+  mix_factor = static_cast<float>(step) / 10.0f;
 }
 
 void init_glfw() {
@@ -179,44 +199,16 @@ void clean_buffer() {
   }
 }
 
-unsigned int create_texture(const char *texture_path) {
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  // set the texture wrapping/filtering options (on currently bound texture)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  int image_w, image_h, image_nCh;
-  stbi_set_flip_vertically_on_load(true);
-  unsigned char *image_data =
-      stbi_load(texture_path, &image_w, &image_h, &image_nCh, 0);
-
-  if (image_data) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, image_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  } else {
-    std::cout << "Failed to load texture" << std::endl;
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_w, image_h, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, image_data);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  stbi_image_free(image_data);
-  return texture;
-}
-
 int main() {
 
   init_glfw();
   auto window = create_window();
   load_glad();
 
-  Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
+  SpecializedShader shader{VERTEX_SRC, FRAGMENT_SRC};
+  shader.setConstant("mixFactor", mix_factor);
 
   // prepare data
   auto VAO = create_vao();
@@ -225,18 +217,20 @@ int main() {
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
   // Prepare Texture data
-  unsigned int texture_floor = create_texture(TEXTURE_PATH_FLOOR.c_str());
-  unsigned int texture_wall = create_texture(TEXTURE_PATH_WALL.c_str());
-
-  // draw our first triangle
-  shader.use();
-  // either set it manually like so:
-  shader.setInt("texture1", 0);
-  // or set it via the texture class
-  shader.setInt("texture2", 1);
-  shader.setInt("texture2_percent", 1.0f);
-
-  std::cout << "press [Esc] to close the window" << std::endl;
+  Texture2D texture_floor{TEXTURE_PATH_FLOOR};
+  Texture2D texture_wall{TEXTURE_PATH_WALL};
+
+  // the generic and the specialized program each need their own values,
+  // typed handles resolve against whichever one use() returned
+  const Uniform<int> TEXTURE1{"texture1"};
+  const Uniform<int> TEXTURE2{"texture2"};
+  const Uniform<glm::mat4> MODEL{"model"};
+  const Uniform<glm::mat4> VIEW{"view"};
+  const Uniform<glm::mat4> PROJECTION{"projection"};
+
+  std::cout << "press [Esc] to close the window, [Up]/[Down] to change the "
+               "texture mix"
+            << std::endl;
   
   {
     glm::vec4 vec(1.0f, 0.0f, 0.0f, 1.0f);
@@ -283,19 +277,20 @@ int main() {
 
     model = glm::rotate(model, rotation_step, glm::vec3(0.5f, 1.0f, 0.0f));
 
-    int modelLoc = glGetUniformLocation(shader.getProgramId(), "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    int viewLoc = glGetUniformLocation(shader.getProgramId(), "view");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    int projectionLoc =
-        glGetUniformLocation(shader.getProgramId(), "projection");
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    // the generic program draws while a new mix factor is being compiled
+    shader.setConstant("mixFactor", mix_factor);
+    Shader &program = shader.use();
+    program.set(TEXTURE1, 0);
+    program.set(TEXTURE2, 1);
+    program.set(MODEL, model);
+    program.set(VIEW, view);
+    program.set(PROJECTION, projection);
 
     glActiveTexture(GL_TEXTURE0); // activate texture unit first
-    glBindTexture(GL_TEXTURE_2D, texture_floor);
+    texture_floor.bind();
 
     glActiveTexture(GL_TEXTURE1); // activate texture unit first
-    glBindTexture(GL_TEXTURE_2D, texture_wall);
+    texture_wall.bind();
 
     glBindVertexArray(VAO);
 
@@ -1,3 +1,6 @@
+#include "common/EmbeddedShaders.h"
+#include "common/TextureLoader.h"
+#include "embedded_shaders.h"
 #include "previous_code.cpp"
 #include <cmath>
 #include <glm/fwd.hpp>
@@ -13,16 +16,23 @@ int main() {
     glEnable(GL_DEPTH_TEST);
   }
 
-  Shader shader{VERTEX_SRC.c_str(), FRAGMENT_SRC.c_str()};
-  unsigned int texture_floor, texture_wall;
+  // all cubes are drawn as instances of one draw call
+  constexpr size_t CUBE_COUNT = 10;
+  // the shader sources are compiled into the executable
+  EmbeddedShaders::add(embedded_shaders::FILES);
+  Shader shader{VERTEX_SRC.c_str(),
+                FRAGMENT_SRC.c_str(),
+                {{"CUBE_COUNT", std::to_string(CUBE_COUNT)}}};
+  std::shared_ptr<Texture2D> texture_floor, texture_wall;
   unsigned int VAO;
   { // prepare data
     VAO = create_vao();
     auto EBO = create_ebo(VAO);
 
-    // Prepare Texture data
-    texture_floor = create_texture(TEXTURE_PATH_FLOOR.c_str());
-    texture_wall = create_texture(TEXTURE_PATH_WALL.c_str());
+    // Prepare Texture data, decoded in the background while the first
+    // frames show a placeholder
+    texture_floor = Texture2D::loadAsync(TEXTURE_PATH_FLOOR);
+    texture_wall = Texture2D::loadAsync(TEXTURE_PATH_WALL);
 
     // draw our first triangle
     shader.use();
@@ -46,8 +56,13 @@ int main() {
         glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
   }
 
+  // Resolve uniforms once, the loop only passes handles
+  auto modelLoc = shader.getUniformHandle("model");
+  auto viewLoc = shader.getUniformHandle("view");
+  auto projectionLoc = shader.getUniformHandle("projection");
+
   // Model positions
-  glm::vec3 cubePositions[] = {
+  glm::vec3 cubePositions[CUBE_COUNT] = {
       glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
       glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
       glm::vec3(2.4f, -0.4f, -3.5f),  glm::vec3(-1.7f, 3.0f, -7.5f),
@@ -67,6 +82,7 @@ int main() {
   while (!glfwWindowShouldClose(window)) {
     // [process input]
     processInput(window);
+    TextureLoader::poll();
 
     // [render]
     // ------
@@ -75,11 +91,12 @@ int main() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glBindVertexArray(VAO);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_floor);
+    texture_floor->bind();
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture_wall);
+    texture_wall->bind();
 
-    for (size_t i = 0; i < 10; ++i) {
+    glm::mat4 models[CUBE_COUNT];
+    for (size_t i = 0; i < CUBE_COUNT; ++i) {
       glm::mat4 model = glm::mat4(1.0f);
       model = glm::translate(model, cubePositions[i]);
 
@@ -89,19 +106,14 @@ int main() {
       float angle = 20.0f * i;
       model =
           glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-
-      // Pass value to shader
-      int modelLoc = glGetUniformLocation(shader.getProgramId(), "model");
-      glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-      int viewLoc = glGetUniformLocation(shader.getProgramId(), "view");
-      glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-      int projectionLoc =
-          glGetUniformLocation(shader.getProgramId(), "projection");
-      glUniformMatrix4fv(projectionLoc, 1, GL_FALSE,
-                         glm::value_ptr(projection));
-
-      glDrawArrays(GL_TRIANGLES, 0, 36);
+      models[i] = model;
     }
+
+    // Pass value to shader, the vertex shader picks model[gl_InstanceID]
+    shader.setMat4fArray(modelLoc, models);
+    shader.setMat4f(viewLoc, view);
+    shader.setMat4f(projectionLoc, projection);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, CUBE_COUNT);
     // glBindVertexArray(0); // no need to unbind it every time
 
     // Check and call events and swap buffers
@@ -124,6 +136,7 @@ int main() {
   }
 
   clean_buffer();
+  TextureLoader::stop();
   // Close
   glfwTerminate();
 
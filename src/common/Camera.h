@@ -51,6 +51,10 @@ public:
     // returns the view matrix calculated using Euler Angles and the LookAt Matrix
     glm::mat4 GetViewMatrix();
 
+    // returns the perspective projection matrix for the current Zoom
+    glm::mat4 GetProjectionMatrix(float aspect, float near = 0.1f,
+                                  float far = 100.0f);
+
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime);
 
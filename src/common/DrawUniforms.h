@@ -0,0 +1,29 @@
+#pragma once
+#include "common.h"
+#include <glm/glm.hpp>
+
+// std140 layout of the per-draw block, allocated from a UniformRing:
+//
+//   layout (std140) uniform DrawUniforms {
+//     mat4 model;
+//     vec4 color;
+//   };
+struct DrawUniformsData {
+  glm::mat4 model;
+  glm::vec4 color;
+};
+
+// Shader binds any DrawUniforms block it finds to BINDING_POINT at link
+// time; each draw then selects its slice of the ring with
+// UniformRing::bind(range, DrawUniforms::BINDING_POINT).
+struct DrawUniforms {
+  static constexpr const char *BLOCK_NAME = "DrawUniforms";
+  // 0 is FrameUniforms, 1 is left to the demos
+  static constexpr GLuint BINDING_POINT = 2;
+
+  static void attach(GLuint program) {
+    auto block = glGetUniformBlockIndex(program, BLOCK_NAME);
+    if (block != GL_INVALID_INDEX)
+      glUniformBlockBinding(program, block, BINDING_POINT);
+  }
+};
@@ -0,0 +1,36 @@
+#include "EmbeddedShaders.h"
+#include <cstdlib>
+#include <unordered_map>
+
+namespace {
+std::unordered_map<std::string_view, EmbeddedFile> &registry() {
+  static std::unordered_map<std::string_view, EmbeddedFile> files;
+  return files;
+}
+
+std::string &source_directory() {
+  static std::string directory = [] {
+    const char *env = std::getenv("SHADER_SOURCE_DIR");
+    return std::string{env ? env : ""};
+  }();
+  return directory;
+}
+} // namespace
+
+void EmbeddedShaders::add(std::span<const EmbeddedFile> files) {
+  for (auto &file : files)
+    registry()[file.path] = file;
+}
+
+const EmbeddedFile *EmbeddedShaders::find(std::string_view path) {
+  auto it = registry().find(path);
+  return it == registry().end() ? nullptr : &it->second;
+}
+
+void EmbeddedShaders::setSourceDirectory(std::string directory) {
+  source_directory() = std::move(directory);
+}
+
+const std::string &EmbeddedShaders::getSourceDirectory() {
+  return source_directory();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <span>
+#include <string>
+#include <string_view>
+
+// shader source compiled into the executable, `path` is relative to src/
+// (e.g. "ch12.1/vertex.sd")
+struct EmbeddedFile {
+  std::string_view path;
+  std::string_view source;
+};
+
+// Registry of the sources generated by the compile_executable CMake macro
+// (see cmake/EmbedShaders.cmake). The preprocessor resolves paths and
+// #includes against it before touching the filesystem.
+class EmbeddedShaders {
+public:
+  static void add(std::span<const EmbeddedFile> files);
+  static const EmbeddedFile *find(std::string_view path);
+
+  // When set, embedded files are read from <directory>/<path> instead if
+  // that file exists, so shaders can be edited without rebuilding.
+  // Defaults to $SHADER_SOURCE_DIR.
+  static void setSourceDirectory(std::string directory);
+  static const std::string &getSourceDirectory();
+};
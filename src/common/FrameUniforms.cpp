@@ -0,0 +1,31 @@
+#include "FrameUniforms.h"
+#include <GLFW/glfw3.h>
+
+FrameUniforms::FrameUniforms() {
+  glGenBuffers(1, &mUbo);
+  glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformsData), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, mUbo);
+}
+
+FrameUniforms::~FrameUniforms() {
+  // the buffer went with the context if the window is already gone
+  if (glfwGetCurrentContext())
+    glDeleteBuffers(1, &mUbo);
+}
+
+void FrameUniforms::update(Camera &camera, float aspect, float near,
+                           float far) {
+  update(camera.GetViewMatrix(),
+         camera.GetProjectionMatrix(aspect, near, far));
+}
+
+void FrameUniforms::update(glm::mat4 const &view,
+                           glm::mat4 const &projection) {
+  FrameUniformsData data{view, projection};
+  glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
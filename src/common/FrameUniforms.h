@@ -0,0 +1,43 @@
+#pragma once
+#include "common.h"
+#include "Camera.h"
+#include <glm/glm.hpp>
+
+// std140 layout of the per-frame block shared by all programs:
+//
+//   layout (std140) uniform FrameUniforms {
+//     mat4 view;
+//     mat4 projection;
+//   };
+struct FrameUniformsData {
+  glm::mat4 view;
+  glm::mat4 projection;
+};
+
+// Uniform buffer holding the per-frame camera matrices. Shader binds any
+// FrameUniforms block it finds to BINDING_POINT at link time, so one update
+// per frame feeds every program.
+class FrameUniforms {
+public:
+  static constexpr const char *BLOCK_NAME = "FrameUniforms";
+  static constexpr GLuint BINDING_POINT = 0;
+
+  FrameUniforms();
+  FrameUniforms(const FrameUniforms &) = delete;
+  FrameUniforms &operator=(const FrameUniforms &) = delete;
+  ~FrameUniforms();
+
+  // bind the program's FrameUniforms block, if it has one, to BINDING_POINT
+  static void attach(GLuint program) {
+    auto block = glGetUniformBlockIndex(program, BLOCK_NAME);
+    if (block != GL_INVALID_INDEX)
+      glUniformBlockBinding(program, block, BINDING_POINT);
+  }
+
+  void update(Camera &camera, float aspect, float near = 0.1f,
+              float far = 100.0f);
+  void update(glm::mat4 const &view, glm::mat4 const &projection);
+
+private:
+  unsigned int mUbo{0};
+};
@@ -0,0 +1,118 @@
+#include "GLExtensions.h"
+#include <GLFW/glfw3.h>
+#include <string>
+#include <unordered_set>
+
+namespace glext {
+
+PFNGETPROGRAMBINARY glGetProgramBinary = nullptr;
+PFNPROGRAMBINARY glProgramBinary = nullptr;
+PFNPROGRAMPARAMETERI glProgramParameteri = nullptr;
+PFNMAXSHADERCOMPILERTHREADS glMaxShaderCompilerThreadsKHR = nullptr;
+PFNGENPROGRAMPIPELINES glGenProgramPipelines = nullptr;
+PFNDELETEPROGRAMPIPELINES glDeleteProgramPipelines = nullptr;
+PFNBINDPROGRAMPIPELINE glBindProgramPipeline = nullptr;
+PFNUSEPROGRAMSTAGES glUseProgramStages = nullptr;
+PFNPROGRAMUNIFORM1I glProgramUniform1i = nullptr;
+PFNPROGRAMUNIFORM1F glProgramUniform1f = nullptr;
+PFNPROGRAMUNIFORMFV glProgramUniform3fv = nullptr;
+PFNPROGRAMUNIFORMMATRIXFV glProgramUniformMatrix4fv = nullptr;
+PFNGETPROGRAMRESOURCEINDEX glGetProgramResourceIndex = nullptr;
+PFNSHADERSTORAGEBLOCKBINDING glShaderStorageBlockBinding = nullptr;
+PFNBUFFERSTORAGE glBufferStorage = nullptr;
+PFNTEXSTORAGE2D glTexStorage2D = nullptr;
+
+namespace {
+bool loaded = false;
+GLint major_version = 0;
+GLint minor_version = 0;
+// binary formats the driver can save programs in, queried once
+GLint program_binary_formats = 0;
+std::unordered_set<std::string> extensions;
+
+template <typename T> void resolve(T &fn, const char *name) {
+  fn = reinterpret_cast<T>(glfwGetProcAddress(name));
+}
+} // namespace
+
+void load() {
+  if (loaded)
+    return;
+  loaded = true;
+
+  glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+  glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i)
+    extensions.emplace(reinterpret_cast<const char *>(
+        glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))));
+
+  if (hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary")) {
+    resolve(glGetProgramBinary, "glGetProgramBinary");
+    resolve(glProgramBinary, "glProgramBinary");
+    resolve(glProgramParameteri, "glProgramParameteri");
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &program_binary_formats);
+  }
+  if (hasVersion(4, 1) || hasExtension("GL_ARB_separate_shader_objects")) {
+    resolve(glProgramParameteri, "glProgramParameteri");
+    resolve(glGenProgramPipelines, "glGenProgramPipelines");
+    resolve(glDeleteProgramPipelines, "glDeleteProgramPipelines");
+    resolve(glBindProgramPipeline, "glBindProgramPipeline");
+    resolve(glUseProgramStages, "glUseProgramStages");
+    resolve(glProgramUniform1i, "glProgramUniform1i");
+    resolve(glProgramUniform1f, "glProgramUniform1f");
+    resolve(glProgramUniform3fv, "glProgramUniform3fv");
+    resolve(glProgramUniformMatrix4fv, "glProgramUniformMatrix4fv");
+  }
+  if (hasVersion(4, 3) ||
+      (hasExtension("GL_ARB_shader_storage_buffer_object") &&
+       hasExtension("GL_ARB_program_interface_query"))) {
+    resolve(glGetProgramResourceIndex, "glGetProgramResourceIndex");
+    resolve(glShaderStorageBlockBinding, "glShaderStorageBlockBinding");
+  }
+  if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+    resolve(glBufferStorage, "glBufferStorage");
+  if (hasVersion(4, 2) || hasExtension("GL_ARB_texture_storage"))
+    resolve(glTexStorage2D, "glTexStorage2D");
+  if (hasExtension("GL_KHR_parallel_shader_compile"))
+    resolve(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsKHR");
+  else if (hasExtension("GL_ARB_parallel_shader_compile"))
+    resolve(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsARB");
+}
+
+bool hasVersion(int major, int minor) {
+  return major_version > major ||
+         (major_version == major && minor_version >= minor);
+}
+
+bool hasExtension(std::string_view name) {
+  return extensions.contains(std::string(name));
+}
+
+bool hasProgramBinary() {
+  return glGetProgramBinary && glProgramBinary && glProgramParameteri &&
+         program_binary_formats > 0;
+}
+
+bool hasParallelShaderCompile() {
+  return glMaxShaderCompilerThreadsKHR != nullptr;
+}
+
+bool hasSeparateShaderObjects() {
+  return glProgramParameteri && glGenProgramPipelines &&
+         glDeleteProgramPipelines && glBindProgramPipeline &&
+         glUseProgramStages && glProgramUniform1i && glProgramUniform1f &&
+         glProgramUniform3fv && glProgramUniformMatrix4fv;
+}
+
+bool hasShaderStorageBuffers() {
+  return glGetProgramResourceIndex && glShaderStorageBlockBinding;
+}
+
+bool hasBufferStorage() { return glBufferStorage != nullptr; }
+
+bool hasTextureStorage() { return glTexStorage2D != nullptr; }
+
+} // namespace glext
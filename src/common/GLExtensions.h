@@ -0,0 +1,136 @@
+#pragma once
+#include "common.h"
+#include <string_view>
+
+// glad is generated for the 3.3 core profile only. Entry points from later
+// versions and extensions are resolved here at runtime and stay null when
+// the driver doesn't provide them, so callers must check before use.
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef GL_VERTEX_SHADER_BIT
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#endif
+#ifndef GL_FRAGMENT_SHADER_BIT
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#endif
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_PROGRAM_SEPARABLE 0x8258
+#endif
+
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_STORAGE_BLOCK
+#define GL_SHADER_STORAGE_BLOCK 0x92E6
+#endif
+#ifndef GL_MAX_SHADER_STORAGE_BLOCK_SIZE
+#define GL_MAX_SHADER_STORAGE_BLOCK_SIZE 0x90DE
+#endif
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace glext {
+
+// GL 4.1 / ARB_get_program_binary
+typedef void(APIENTRYP PFNGETPROGRAMBINARY)(GLuint program, GLsizei bufSize,
+                                            GLsizei *length,
+                                            GLenum *binaryFormat,
+                                            void *binary);
+typedef void(APIENTRYP PFNPROGRAMBINARY)(GLuint program, GLenum binaryFormat,
+                                         const void *binary, GLsizei length);
+typedef void(APIENTRYP PFNPROGRAMPARAMETERI)(GLuint program, GLenum pname,
+                                             GLint value);
+
+extern PFNGETPROGRAMBINARY glGetProgramBinary;
+extern PFNPROGRAMBINARY glProgramBinary;
+extern PFNPROGRAMPARAMETERI glProgramParameteri;
+
+// GL_KHR_parallel_shader_compile (or the ARB variant)
+typedef void(APIENTRYP PFNMAXSHADERCOMPILERTHREADS)(GLuint count);
+
+extern PFNMAXSHADERCOMPILERTHREADS glMaxShaderCompilerThreadsKHR;
+
+// GL 4.1 / ARB_separate_shader_objects, together with glProgramParameteri
+typedef void(APIENTRYP PFNGENPROGRAMPIPELINES)(GLsizei n, GLuint *pipelines);
+typedef void(APIENTRYP PFNDELETEPROGRAMPIPELINES)(GLsizei n,
+                                                  const GLuint *pipelines);
+typedef void(APIENTRYP PFNBINDPROGRAMPIPELINE)(GLuint pipeline);
+typedef void(APIENTRYP PFNUSEPROGRAMSTAGES)(GLuint pipeline, GLbitfield stages,
+                                            GLuint program);
+typedef void(APIENTRYP PFNPROGRAMUNIFORM1I)(GLuint program, GLint location,
+                                            GLint v0);
+typedef void(APIENTRYP PFNPROGRAMUNIFORM1F)(GLuint program, GLint location,
+                                            GLfloat v0);
+typedef void(APIENTRYP PFNPROGRAMUNIFORMFV)(GLuint program, GLint location,
+                                            GLsizei count,
+                                            const GLfloat *value);
+typedef void(APIENTRYP PFNPROGRAMUNIFORMMATRIXFV)(GLuint program,
+                                                  GLint location,
+                                                  GLsizei count,
+                                                  GLboolean transpose,
+                                                  const GLfloat *value);
+
+extern PFNGENPROGRAMPIPELINES glGenProgramPipelines;
+extern PFNDELETEPROGRAMPIPELINES glDeleteProgramPipelines;
+extern PFNBINDPROGRAMPIPELINE glBindProgramPipeline;
+extern PFNUSEPROGRAMSTAGES glUseProgramStages;
+extern PFNPROGRAMUNIFORM1I glProgramUniform1i;
+extern PFNPROGRAMUNIFORM1F glProgramUniform1f;
+extern PFNPROGRAMUNIFORMFV glProgramUniform3fv;
+extern PFNPROGRAMUNIFORMMATRIXFV glProgramUniformMatrix4fv;
+
+// GL 4.3 / ARB_shader_storage_buffer_object + ARB_program_interface_query
+typedef GLuint(APIENTRYP PFNGETPROGRAMRESOURCEINDEX)(GLuint program,
+                                                     GLenum programInterface,
+                                                     const GLchar *name);
+typedef void(APIENTRYP PFNSHADERSTORAGEBLOCKBINDING)(GLuint program,
+                                                     GLuint storageBlockIndex,
+                                                     GLuint storageBlockBinding);
+
+extern PFNGETPROGRAMRESOURCEINDEX glGetProgramResourceIndex;
+extern PFNSHADERSTORAGEBLOCKBINDING glShaderStorageBlockBinding;
+
+// GL 4.4 / ARB_buffer_storage
+typedef void(APIENTRYP PFNBUFFERSTORAGE)(GLenum target, GLsizeiptr size,
+                                         const void *data, GLbitfield flags);
+
+extern PFNBUFFERSTORAGE glBufferStorage;
+
+// GL 4.2 / ARB_texture_storage
+typedef void(APIENTRYP PFNTEXSTORAGE2D)(GLenum target, GLsizei levels,
+                                        GLenum internalformat, GLsizei width,
+                                        GLsizei height);
+
+extern PFNTEXSTORAGE2D glTexStorage2D;
+
+// resolve the entry points above; needs a current context, safe to call
+// repeatedly
+void load();
+bool hasVersion(int major, int minor);
+bool hasExtension(std::string_view name);
+bool hasProgramBinary();
+// GL_KHR_parallel_shader_compile, links can be polled without blocking
+bool hasParallelShaderCompile();
+bool hasSeparateShaderObjects();
+bool hasShaderStorageBuffers();
+bool hasBufferStorage();
+bool hasTextureStorage();
+
+} // namespace glext
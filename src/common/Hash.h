@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+// FNV-1a, usable at compile time. Pass the previous result as seed to hash
+// several pieces as one stream.
+constexpr uint64_t fnv1a(std::string_view data,
+                         uint64_t seed = FNV_OFFSET_BASIS) {
+  uint64_t hash = seed;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
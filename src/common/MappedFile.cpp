@@ -0,0 +1,43 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    mError = std::strerror(errno);
+    return;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    mError = std::strerror(errno);
+    ::close(fd);
+    return;
+  }
+
+  mSize = static_cast<size_t>(info.st_size);
+  // mmap rejects empty ranges, an empty file is simply an empty view
+  if (mSize > 0) {
+    mData = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mData == MAP_FAILED) {
+      mError = std::strerror(errno);
+      mData = nullptr;
+      mSize = 0;
+      ::close(fd);
+      return;
+    }
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+  mOpen = true;
+}
+
+MappedFile::~MappedFile() {
+  if (mData)
+    ::munmap(mData, mSize);
+}
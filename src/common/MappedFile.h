@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. Check isOpen() after
+// construction; error() describes why the file could not be mapped.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  bool isOpen() const { return mOpen; }
+  const std::string &error() const { return mError; }
+  std::string_view view() const {
+    return {static_cast<const char *>(mData), mSize};
+  }
+
+private:
+  void *mData{nullptr};
+  size_t mSize{0};
+  bool mOpen{false};
+  std::string mError;
+};
@@ -0,0 +1,103 @@
+#include "PixelBufferRing.h"
+#include "GLExtensions.h"
+
+PixelBufferRing::PixelBufferRing(size_t slotCount, size_t slotBytes)
+    : mSlots(slotCount), mSlotBytes(slotBytes) {
+  glext::load();
+  mPersistent = glext::hasBufferStorage();
+  auto size = static_cast<GLsizeiptr>(mSlotBytes);
+  for (auto &slot : mSlots) {
+    glGenBuffers(1, &slot.pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    if (mPersistent)
+      glext::glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr,
+                             GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                 GL_MAP_COHERENT_BIT);
+    else
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  // no fences yet, every slot is mapped and freed right away
+  reclaim();
+}
+
+PixelBufferRing::~PixelBufferRing() {
+  for (auto &slot : mSlots) {
+    if (slot.fence)
+      glDeleteSync(slot.fence);
+    if (slot.memory) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glDeleteBuffers(1, &slot.pbo);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+int PixelBufferRing::acquire(size_t bytes) {
+  if (bytes > mSlotBytes)
+    return -1;
+  std::lock_guard lock{mMutex};
+  for (size_t i = 0; i < mSlots.size(); ++i) {
+    if (mSlots[i].state != SlotState::Free)
+      continue;
+    mSlots[i].state = SlotState::Filling;
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void PixelBufferRing::release(int slot) {
+  std::lock_guard lock{mMutex};
+  mSlots[static_cast<size_t>(slot)].state = SlotState::Free;
+}
+
+void PixelBufferRing::bind(int slot) {
+  auto &s = mSlots[static_cast<size_t>(slot)];
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo);
+  if (mPersistent)
+    return;
+  // GL can't read a buffer while it is mapped
+  std::lock_guard lock{mMutex};
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  s.memory = nullptr;
+}
+
+void PixelBufferRing::submit(int slot) {
+  auto &s = mSlots[static_cast<size_t>(slot)];
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  std::lock_guard lock{mMutex};
+  s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  s.state = SlotState::InFlight;
+}
+
+void PixelBufferRing::reclaim() {
+  std::lock_guard lock{mMutex};
+  for (auto &slot : mSlots) {
+    if (slot.state != SlotState::InFlight)
+      continue;
+    if (slot.fence) {
+      if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        continue;
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+    }
+    if (map(slot))
+      slot.state = SlotState::Free;
+  }
+}
+
+bool PixelBufferRing::map(Slot &slot) {
+  if (slot.memory)
+    return true;
+  GLbitfield flags = GL_MAP_WRITE_BIT;
+  // the fence has signaled, nothing reads the old contents anymore
+  flags |= mPersistent ? GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+                       : GL_MAP_INVALIDATE_BUFFER_BIT |
+                             GL_MAP_UNSYNCHRONIZED_BIT;
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+  slot.memory = static_cast<unsigned char *>(glMapBufferRange(
+      GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(mSlotBytes), flags));
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  return slot.memory != nullptr;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "common.h"
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Ring of pixel unpack buffers for streaming texture uploads. A free slot
+// is mapped memory that any thread may acquire() and fill; the render
+// thread then bind()s it, sources glTex*Image2D from it and submit()s it,
+// which fences the slot until the GPU has read it. reclaim() returns
+// finished slots to the free list.
+//
+// With GL 4.4 / ARB_buffer_storage the buffers stay mapped persistently;
+// otherwise a slot is mapped again, unsynchronized, when it is reclaimed.
+class PixelBufferRing {
+public:
+  PixelBufferRing(size_t slotCount, size_t slotBytes);
+  PixelBufferRing(const PixelBufferRing &) = delete;
+  PixelBufferRing &operator=(const PixelBufferRing &) = delete;
+  ~PixelBufferRing();
+
+  // any thread: a free slot for `bytes`, -1 if none is free or it's too
+  // large for a slot
+  int acquire(size_t bytes);
+  unsigned char *memory(int slot) const {
+    return mSlots[static_cast<size_t>(slot)].memory;
+  }
+  // any thread: give an acquired slot back unused
+  void release(int slot);
+
+  // render thread: bind an acquired slot as GL_PIXEL_UNPACK_BUFFER
+  void bind(int slot);
+  // render thread: unbind and fence the slot after the uploads from it
+  void submit(int slot);
+  // render thread: map slots whose uploads finished and free them
+  void reclaim();
+
+  size_t getSlotBytes() const { return mSlotBytes; }
+  bool persistent() const { return mPersistent; }
+
+private:
+  enum class SlotState { Free, Filling, InFlight };
+  struct Slot {
+    GLuint pbo{0};
+    unsigned char *memory{nullptr};
+    GLsync fence{nullptr};
+    SlotState state{SlotState::InFlight};
+  };
+
+  bool map(Slot &slot);
+
+  std::vector<Slot> mSlots;
+  size_t mSlotBytes;
+  bool mPersistent{false};
+  // guards the slot states and memory pointers
+  std::mutex mMutex;
+};
@@ -0,0 +1,136 @@
+#include "ProgramBinaryCache.h"
+#include "GLExtensions.h"
+#include "Hash.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+struct CacheHeader {
+  char magic[4]{'G', 'L', 'P', 'B'};
+  uint32_t version{1};
+  uint64_t key{0};
+  uint32_t format{0};
+  uint32_t length{0};
+};
+
+std::string &cache_directory() {
+  static std::string directory = [] {
+    const char *env = std::getenv("SHADER_CACHE_DIR");
+    return std::string{env ? env : ".shader_cache"};
+  }();
+  return directory;
+}
+
+std::string_view gl_string(GLenum name) {
+  auto *str = reinterpret_cast<const char *>(glGetString(name));
+  return str ? str : "";
+}
+} // namespace
+
+void ProgramBinaryCache::setDirectory(std::string directory) {
+  cache_directory() = std::move(directory);
+}
+
+const std::string &ProgramBinaryCache::getDirectory() {
+  return cache_directory();
+}
+
+bool ProgramBinaryCache::enabled() {
+  glext::load();
+  return !cache_directory().empty() && glext::hasProgramBinary();
+}
+
+uint64_t ProgramBinaryCache::key(
+    std::initializer_list<std::span<const std::string_view>> stages) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (auto segments : stages) {
+    // hashing segment by segment equals hashing the joined text
+    for (auto segment : segments)
+      hash = fnv1a(segment, hash);
+    // separator, so moving text between stages changes the key
+    hash = fnv1a(std::string_view{"\0", 1}, hash);
+  }
+  hash = fnv1a(gl_string(GL_VENDOR), hash);
+  hash = fnv1a(gl_string(GL_RENDERER), hash);
+  hash = fnv1a(gl_string(GL_VERSION), hash);
+  return hash;
+}
+
+unsigned int ProgramBinaryCache::load(uint64_t key) {
+  if (!enabled())
+    return 0;
+
+  std::ifstream file{path(key), std::ios::binary};
+  if (!file)
+    return 0;
+
+  CacheHeader header, expected;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || std::string_view{header.magic, 4} != "GLPB" ||
+      header.version != expected.version || header.key != key)
+    return 0;
+
+  std::vector<char> binary(header.length);
+  file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+  if (!file)
+    return 0;
+
+  unsigned int program = glCreateProgram();
+  glext::glProgramBinary(program, header.format, binary.data(),
+                         static_cast<GLsizei>(header.length));
+  int success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    // stale for this driver; drop it so the fresh binary replaces it
+    glDeleteProgram(program);
+    std::error_code ec;
+    std::filesystem::remove(path(key), ec);
+    return 0;
+  }
+  return program;
+}
+
+void ProgramBinaryCache::prepare(unsigned int program) {
+  if (enabled())
+    glext::glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                               GL_TRUE);
+}
+
+void ProgramBinaryCache::store(uint64_t key, unsigned int program) {
+  if (!enabled())
+    return;
+
+  int success, length;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (!success || length <= 0)
+    return;
+
+  CacheHeader header;
+  header.key = key;
+  std::vector<char> binary(static_cast<size_t>(length));
+  GLenum format = 0;
+  glext::glGetProgramBinary(program, length, nullptr, &format, binary.data());
+  header.format = format;
+  header.length = static_cast<uint32_t>(length);
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_directory(), ec);
+  std::ofstream file{path(key), std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(binary.data(), length);
+  if (!file)
+    std::cout << "WARNING: could not write program binary " << path(key)
+              << std::endl;
+}
+
+std::string ProgramBinaryCache::path(uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin",
+                static_cast<unsigned long long>(key));
+  return (std::filesystem::path{cache_directory()} / name).string();
+}
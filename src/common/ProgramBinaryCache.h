@@ -0,0 +1,32 @@
+#pragma once
+#include "common.h"
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Stores linked program binaries on disk so later launches can skip
+// compiling and linking. Entries are keyed by the final shader sources and
+// the driver identity, a driver update therefore simply misses the cache.
+class ProgramBinaryCache {
+public:
+  // defaults to $SHADER_CACHE_DIR or ".shader_cache", empty disables caching
+  static void setDirectory(std::string directory);
+  static const std::string &getDirectory();
+
+  static bool enabled();
+  // one entry per stage, each given as the segments passed to glShaderSource
+  static uint64_t
+  key(std::initializer_list<std::span<const std::string_view>> stages);
+
+  // returns a linked program created from the cached binary, or 0 when there
+  // is no usable entry
+  static unsigned int load(uint64_t key);
+  // must be called before linking for the driver to keep the binary around
+  static void prepare(unsigned int program);
+  static void store(uint64_t key, unsigned int program);
+
+private:
+  static std::string path(uint64_t key);
+};
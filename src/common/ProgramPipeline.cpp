@@ -0,0 +1,238 @@
+#include "ProgramPipeline.h"
+#include "DrawUniforms.h"
+#include "FrameUniforms.h"
+#include "GLExtensions.h"
+#include "Hash.h"
+#include "shader.h"
+#include <GLFW/glfw3.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+ShaderStage::ShaderStage(GLenum type, const PreprocessedSource &source)
+    : mType(type) {
+  std::vector<const GLchar *> strings;
+  std::vector<GLint> lengths;
+  for (auto segment : source.segments) {
+    strings.push_back(segment.data());
+    lengths.push_back(static_cast<GLint>(segment.size()));
+  }
+
+  // what glCreateShaderProgramv does, but keeping the explicit lengths so
+  // the mapped sources don't have to be joined and terminated first
+  auto shader = glCreateShader(type);
+  glShaderSource(shader, static_cast<GLsizei>(strings.size()), strings.data(),
+                 lengths.data());
+  glCompileShader(shader);
+
+  mId = glCreateProgram();
+  glext::glProgramParameteri(mId, GL_PROGRAM_SEPARABLE, GL_TRUE);
+  glAttachShader(mId, shader);
+  glLinkProgram(mId);
+  glDetachShader(mId, shader);
+
+  int success;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  if (!success)
+    std::cout << "ERROR Failed to compile SHADER STAGE('" << source.files[0]
+              << "'," << type << ")\n"
+              << shaderInfoLog(shader) << std::endl;
+  glDeleteShader(shader);
+
+  glGetProgramiv(mId, GL_LINK_STATUS, &success);
+  if (!success) {
+    std::cout << "ERROR::SHADER::STAGE::LINKING_FAILED\n"
+              << programInfoLog(mId) << std::endl;
+    return;
+  }
+  mLinked = true;
+  mUniforms.load(mId);
+  FrameUniforms::attach(mId);
+  DrawUniforms::attach(mId);
+}
+
+ShaderStage::~ShaderStage() {
+  if (glfwGetCurrentContext())
+    glDeleteProgram(mId);
+}
+
+GLint ShaderStage::getUniformLocation(std::string_view name) const {
+  return getUniformLocation(hashUniformName(name), name);
+}
+
+GLint ShaderStage::getUniformLocation(uint64_t hash,
+                                      std::string_view name) const {
+  auto handle = mUniforms.find(hash, name);
+  return handle == INVALID_UNIFORM ? -1 : mUniforms[handle].location;
+}
+
+namespace {
+std::unordered_map<uint64_t, std::weak_ptr<ShaderStage>> &stages() {
+  static std::unordered_map<uint64_t, std::weak_ptr<ShaderStage>> entries;
+  return entries;
+}
+} // namespace
+
+std::shared_ptr<ShaderStage> StageCache::get(GLenum type,
+                                             const std::string &path,
+                                             const ShaderDefines &defines) {
+  auto stageDefines = defines;
+  if (type == GL_VERTEX_SHADER)
+    stageDefines["SEPARABLE_STAGE"] = "";
+  auto source = ShaderPreprocessor::process(path, stageDefines);
+  if (!source.ok)
+    return nullptr;
+
+  // keyed by content, identical text reached through different files or
+  // defines still shares one stage
+  auto key = fnv1a(std::string_view{reinterpret_cast<const char *>(&type),
+                                    sizeof(type)});
+  for (auto segment : source.segments)
+    key = fnv1a(segment, key);
+
+  // drop the entries of stages that are gone
+  std::erase_if(stages(), [](auto &entry) { return entry.second.expired(); });
+  auto &entry = stages()[key];
+  auto stage = entry.lock();
+  if (!stage) {
+    stage = std::make_shared<ShaderStage>(type, source);
+    entry = stage;
+  }
+  return stage;
+}
+
+size_t StageCache::size() {
+  std::erase_if(stages(), [](auto &entry) { return entry.second.expired(); });
+  return stages().size();
+}
+
+bool ProgramPipeline::supported() {
+  glext::load();
+  return glext::hasSeparateShaderObjects();
+}
+
+ProgramPipeline::ProgramPipeline(const char *vertexPath,
+                                 const char *fragmentPath,
+                                 const ShaderDefines &defines)
+    : ProgramPipeline(vertexPath, fragmentPath, defines, defines) {}
+
+ProgramPipeline::ProgramPipeline(const char *vertexPath,
+                                 const char *fragmentPath,
+                                 const ShaderDefines &vertexDefines,
+                                 const ShaderDefines &fragmentDefines) {
+  if (!supported()) {
+    std::cout << "ERROR::SHADER::PIPELINE separate shader objects are not "
+                 "supported by this context"
+              << std::endl;
+    return;
+  }
+  mVertex = StageCache::get(GL_VERTEX_SHADER, vertexPath, vertexDefines);
+  mFragment =
+      StageCache::get(GL_FRAGMENT_SHADER, fragmentPath, fragmentDefines);
+
+  glext::glGenProgramPipelines(1, &mId);
+  if (mVertex && mVertex->isLinked())
+    glext::glUseProgramStages(mId, GL_VERTEX_SHADER_BIT,
+                              mVertex->getProgramId());
+  if (mFragment && mFragment->isLinked())
+    glext::glUseProgramStages(mId, GL_FRAGMENT_SHADER_BIT,
+                              mFragment->getProgramId());
+}
+
+ProgramPipeline::~ProgramPipeline() {
+  if (mId != 0 && glfwGetCurrentContext())
+    glext::glDeleteProgramPipelines(1, &mId);
+}
+
+bool ProgramPipeline::isReady() const {
+  return mId != 0 && mVertex && mVertex->isLinked() && mFragment &&
+         mFragment->isLinked();
+}
+
+void ProgramPipeline::use() {
+  // without separate shader objects there is nothing to bind, and no
+  // glBindProgramPipeline to call
+  if (mId == 0)
+    return;
+  // a program bound with glUseProgram takes precedence over the pipeline
+  Shader::unbind();
+  glext::glBindProgramPipeline(mId);
+}
+
+template <typename F>
+void ProgramPipeline::for_each_location(uint64_t hash, std::string_view name,
+                                        F &&set) const {
+  for (auto *stage : {mVertex.get(), mFragment.get()}) {
+    if (!stage)
+      continue;
+    auto location = stage->getUniformLocation(hash, name);
+    if (location >= 0)
+      set(stage->getProgramId(), location);
+  }
+}
+
+void ProgramPipeline::setInt(const std::string &name, int value) const {
+  set(hashUniformName(name), name, value);
+}
+
+void ProgramPipeline::setFloat(const std::string &name, float value) const {
+  set(hashUniformName(name), name, value);
+}
+
+void ProgramPipeline::setVec3(const std::string &name,
+                              glm::vec3 const &vec3) const {
+  set(hashUniformName(name), name, vec3);
+}
+
+void ProgramPipeline::setMat4f(const std::string &name,
+                               glm::mat4 const &mat) const {
+  set(hashUniformName(name), name, mat);
+}
+
+void ProgramPipeline::set(const Uniform<int> &uniform, int value) const {
+  set(uniform.hash(), uniform.name(), value);
+}
+
+void ProgramPipeline::set(const Uniform<float> &uniform, float value) const {
+  set(uniform.hash(), uniform.name(), value);
+}
+
+void ProgramPipeline::set(const Uniform<glm::vec3> &uniform,
+                          glm::vec3 const &vec3) const {
+  set(uniform.hash(), uniform.name(), vec3);
+}
+
+void ProgramPipeline::set(const Uniform<glm::mat4> &uniform,
+                          glm::mat4 const &mat) const {
+  set(uniform.hash(), uniform.name(), mat);
+}
+
+void ProgramPipeline::set(uint64_t hash, std::string_view name,
+                          int value) const {
+  for_each_location(hash, name, [&](GLuint program, GLint location) {
+    glext::glProgramUniform1i(program, location, value);
+  });
+}
+
+void ProgramPipeline::set(uint64_t hash, std::string_view name,
+                          float value) const {
+  for_each_location(hash, name, [&](GLuint program, GLint location) {
+    glext::glProgramUniform1f(program, location, value);
+  });
+}
+
+void ProgramPipeline::set(uint64_t hash, std::string_view name,
+                          glm::vec3 const &vec3) const {
+  for_each_location(hash, name, [&](GLuint program, GLint location) {
+    glext::glProgramUniform3fv(program, location, 1, glm::value_ptr(vec3));
+  });
+}
+
+void ProgramPipeline::set(uint64_t hash, std::string_view name,
+                          glm::mat4 const &mat) const {
+  for_each_location(hash, name, [&](GLuint program, GLint location) {
+    glext::glProgramUniformMatrix4fv(program, location, 1, GL_FALSE,
+                                     glm::value_ptr(mat));
+  });
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "common.h"
+#include "ShaderPreprocessor.h"
+#include "Uniform.h"
+#include "UniformTable.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+
+// A separable program (GL_PROGRAM_SEPARABLE) holding a single stage
+class ShaderStage {
+public:
+  ShaderStage(GLenum type, const PreprocessedSource &source);
+  ShaderStage(const ShaderStage &) = delete;
+  ShaderStage &operator=(const ShaderStage &) = delete;
+  ~ShaderStage();
+
+  GLenum getType() const { return mType; }
+  unsigned int getProgramId() const { return mId; }
+  bool isLinked() const { return mLinked; }
+  GLint getUniformLocation(std::string_view name) const;
+  GLint getUniformLocation(uint64_t hash, std::string_view name) const;
+
+private:
+  GLenum mType;
+  unsigned int mId{0};
+  bool mLinked{false};
+  UniformTable mUniforms;
+};
+
+// Compiles every distinct stage source once, so the number of compile and
+// link operations grows with unique stages instead of with the vertex x
+// fragment combinations in use. A stage is deleted together with the last
+// pipeline using it; the cache only holds weak references.
+class StageCache {
+public:
+  static std::shared_ptr<ShaderStage> get(GLenum type, const std::string &path,
+                                          const ShaderDefines &defines = {});
+  // stages currently alive
+  static size_t size();
+};
+
+// Alternative to Shader built from cached separable stages and bound with
+// glBindProgramPipeline. Needs GL 4.1 or ARB_separate_shader_objects, check
+// supported() first. Vertex stages are built with SEPARABLE_STAGE defined;
+// vertex shaders redeclare gl_PerVertex under it, which strict drivers
+// insist on for separable programs (see ch12.1/vertex.sd).
+class ProgramPipeline {
+public:
+  static bool supported();
+
+  ProgramPipeline(const char *vertexPath, const char *fragmentPath,
+                  const ShaderDefines &defines = {});
+  // separate defines per stage, so pipelines that only differ in one stage
+  // share the other
+  ProgramPipeline(const char *vertexPath, const char *fragmentPath,
+                  const ShaderDefines &vertexDefines,
+                  const ShaderDefines &fragmentDefines);
+  ProgramPipeline(const ProgramPipeline &) = delete;
+  ProgramPipeline &operator=(const ProgramPipeline &) = delete;
+  ~ProgramPipeline();
+
+  bool isReady() const;
+  // does nothing when the pipeline couldn't be created
+  void use();
+
+  // uniforms are written to every stage that declares them
+  void setInt(const std::string &name, int value) const;
+  void setFloat(const std::string &name, float value) const;
+  void setVec3(const std::string &name, glm::vec3 const &vec3) const;
+  void setMat4f(const std::string &name, glm::mat4 const &mat) const;
+  // same with the name hashed at compile time, see Uniform
+  void set(const Uniform<int> &uniform, int value) const;
+  void set(const Uniform<float> &uniform, float value) const;
+  void set(const Uniform<glm::vec3> &uniform, glm::vec3 const &vec3) const;
+  void set(const Uniform<glm::mat4> &uniform, glm::mat4 const &mat) const;
+
+private:
+  unsigned int mId{0};
+  std::shared_ptr<ShaderStage> mVertex;
+  std::shared_ptr<ShaderStage> mFragment;
+
+  void set(uint64_t hash, std::string_view name, int value) const;
+  void set(uint64_t hash, std::string_view name, float value) const;
+  void set(uint64_t hash, std::string_view name, glm::vec3 const &vec3) const;
+  void set(uint64_t hash, std::string_view name, glm::mat4 const &mat) const;
+  template <typename F>
+  void for_each_location(uint64_t hash, std::string_view name, F &&set) const;
+};
@@ -0,0 +1,60 @@
+#include "ShaderLibrary.h"
+#include <filesystem>
+#include <unordered_map>
+
+namespace {
+std::unordered_map<std::string, std::weak_ptr<Shader>> &programs() {
+  static std::unordered_map<std::string, std::weak_ptr<Shader>> entries;
+  return entries;
+}
+
+// same rules as ShaderPreprocessor: embedded files by their src/-relative
+// path, everything else by its location on disk
+std::string source_identity(const std::string &path) {
+  auto normal = std::filesystem::path{path}.lexically_normal().generic_string();
+  if (EmbeddedShaders::find(normal))
+    return normal;
+  std::error_code error;
+  auto canonical = std::filesystem::weakly_canonical(path, error);
+  return error ? normal : canonical.string();
+}
+
+template <typename Create>
+std::shared_ptr<Shader> find_or_create(const std::string &key,
+                                       Create &&create) {
+  auto &entry = programs()[key];
+  auto shader = entry.lock();
+  if (!shader) {
+    shader = create();
+    entry = shader;
+  }
+  return shader;
+}
+} // namespace
+
+std::shared_ptr<Shader> ShaderLibrary::get(const std::string &vertexPath,
+                                           const std::string &fragmentPath,
+                                           const ShaderDefines &defines) {
+  auto key = source_identity(vertexPath) + '\n' +
+             source_identity(fragmentPath) + '\n' + permutationKey(defines);
+  return find_or_create(key, [&] {
+    return std::make_shared<Shader>(vertexPath.c_str(), fragmentPath.c_str(),
+                                    defines);
+  });
+}
+
+std::shared_ptr<Shader> ShaderLibrary::get(const EmbeddedFile &vertex,
+                                           const EmbeddedFile &fragment,
+                                           const ShaderDefines &defines) {
+  auto key = source_identity(std::string{vertex.path}) + '\n' +
+             source_identity(std::string{fragment.path}) + '\n' +
+             permutationKey(defines);
+  return find_or_create(
+      key, [&] { return std::make_shared<Shader>(vertex, fragment, defines); });
+}
+
+size_t ShaderLibrary::size() {
+  // drop the entries of programs that are gone
+  std::erase_if(programs(), [](auto &entry) { return entry.second.expired(); });
+  return programs().size();
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "EmbeddedShaders.h"
+#include "ShaderPreprocessor.h"
+#include "shader.h"
+#include <memory>
+#include <string>
+
+// Shares one Shader between everyone asking for the same vertex/fragment
+// sources and defines, so duplicates don't cost another compile, link and
+// program object. Sources are identified by their canonical path (the
+// src/-relative path for embedded files). The program is deleted with the
+// last handle.
+class ShaderLibrary {
+public:
+  static std::shared_ptr<Shader> get(const std::string &vertexPath,
+                                     const std::string &fragmentPath,
+                                     const ShaderDefines &defines = {});
+  static std::shared_ptr<Shader> get(const EmbeddedFile &vertex,
+                                     const EmbeddedFile &fragment,
+                                     const ShaderDefines &defines = {});
+  // programs currently alive
+  static size_t size();
+};
@@ -0,0 +1,304 @@
+#include "ShaderPreprocessor.h"
+#include "EmbeddedShaders.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+std::string permutationKey(const ShaderDefines &defines) {
+  std::string key;
+  for (auto &[name, value] : defines) {
+    if (!key.empty())
+      key += ';';
+    key += name;
+    if (!value.empty())
+      key += '=' + value;
+  }
+  return key;
+}
+
+namespace {
+std::string_view trim_left(std::string_view line) {
+  auto start = line.find_first_not_of(" \t");
+  return start == std::string_view::npos ? std::string_view{}
+                                         : line.substr(start);
+}
+
+// returns the quoted file name of an `#include "file"` line, or empty
+std::string_view include_target(std::string_view line) {
+  line = trim_left(line);
+  if (!line.starts_with('#'))
+    return {};
+  line = trim_left(line.substr(1));
+  if (!line.starts_with("include"))
+    return {};
+  line = trim_left(line.substr(7));
+  auto close = line.find('"', 1);
+  if (!line.starts_with('"') || close == std::string_view::npos)
+    return {};
+  return line.substr(1, close - 1);
+}
+
+// line number of the #version directive, 0 if there is none; it has to
+// come first, only comments and white space may precede it
+size_t version_line(std::string_view text) {
+  size_t line = 1;
+  size_t i = 0;
+  while (i < text.size()) {
+    auto rest = text.substr(i);
+    if (rest.starts_with("//")) {
+      i = text.find('\n', i);
+    } else if (rest.starts_with("/*")) {
+      auto close = text.find("*/", i + 2);
+      if (close == std::string_view::npos)
+        return 0;
+      line += static_cast<size_t>(
+          std::count(rest.begin(), rest.begin() + (close - i), '\n'));
+      i = close + 2;
+    } else if (rest[0] == '\n') {
+      ++line;
+      ++i;
+    } else if (rest[0] == ' ' || rest[0] == '\t' || rest[0] == '\r') {
+      ++i;
+    } else {
+      bool version = rest.starts_with('#') &&
+                     trim_left(rest.substr(1)).starts_with("version");
+      return version ? line : 0;
+    }
+  }
+  return 0;
+}
+} // namespace
+
+std::string stripShaderSource(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  bool inComment = false;
+  std::string_view rest{text};
+  while (!rest.empty()) {
+    auto end = rest.find('\n');
+    auto line = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view{}
+                                         : rest.substr(end + 1);
+
+    // only directives (#include "...") contain quoted text
+    bool directive = trim_left(line).starts_with('#');
+    bool inQuotes = false;
+    auto lineStart = out.size();
+    auto space = [&] {
+      if (out.size() > lineStart && out.back() != ' ')
+        out += ' ';
+    };
+    for (size_t i = 0; i < line.size(); ++i) {
+      char c = line[i];
+      char next = i + 1 < line.size() ? line[i + 1] : '\0';
+      if (inComment) {
+        if (c == '*' && next == '/') {
+          inComment = false;
+          ++i;
+        }
+        continue;
+      }
+      if (directive && c == '"')
+        inQuotes = !inQuotes;
+      if (!inQuotes && c == '/' && next == '/')
+        break;
+      if (!inQuotes && c == '/' && next == '*') {
+        inComment = true;
+        space();
+        ++i;
+        continue;
+      }
+      if (!inQuotes && (c == ' ' || c == '\t' || c == '\r')) {
+        space();
+        continue;
+      }
+      out += c;
+    }
+    if (out.size() > lineStart && out.back() == ' ')
+      out.pop_back();
+    if (end != std::string_view::npos)
+      out += '\n';
+  }
+  return out;
+}
+
+PreprocessedSource ShaderPreprocessor::process(const std::string &path,
+                                               const ShaderDefines &defines) {
+  PreprocessedSource out;
+  std::vector<std::string> active;
+  out.ok = expand(path, nullptr, out, &defines, active);
+  return out;
+}
+
+PreprocessedSource ShaderPreprocessor::process(const EmbeddedFile &file,
+                                               const ShaderDefines &defines) {
+  PreprocessedSource out;
+  std::vector<std::string> active;
+  out.ok = expand(std::string{file.path}, &file.source, out, &defines, active);
+  return out;
+}
+
+bool ShaderSources::read(PreprocessedSource *vertexCode,
+                         PreprocessedSource *fragCode) const {
+  // both stages see the same defines so they agree on the variant
+  if (embedded) {
+    *vertexCode =
+        ShaderPreprocessor::process(EmbeddedFile{vertexPath, vertexText}, defines);
+    *fragCode = ShaderPreprocessor::process(
+        EmbeddedFile{fragmentPath, fragmentText}, defines);
+  } else {
+    *vertexCode = ShaderPreprocessor::process(vertexPath, defines);
+    *fragCode = ShaderPreprocessor::process(fragmentPath, defines);
+  }
+  return vertexCode->ok && fragCode->ok;
+}
+
+std::string PreprocessedSource::str() const {
+  std::string text;
+  for (auto segment : segments)
+    text += segment;
+  return text;
+}
+
+bool ShaderPreprocessor::open(const std::string &path,
+                              const std::string_view *source,
+                              PreprocessedSource &out, std::string_view *text,
+                              std::string *identity) {
+  auto map = [&](const std::string &file) {
+    auto mapping = std::make_unique<MappedFile>(file);
+    if (!mapping->isOpen())
+      return false;
+    *text = mapping->view();
+    *identity = std::filesystem::weakly_canonical(file).string();
+    out.mappings.push_back(std::move(mapping));
+    return true;
+  };
+
+  // embedded sources use paths relative to src/, which may be overridden by
+  // the files on disk for hot reload
+  auto normal = std::filesystem::path{path}.lexically_normal().generic_string();
+  auto *embedded = EmbeddedShaders::find(normal);
+  if (source || embedded) {
+    auto &directory = EmbeddedShaders::getSourceDirectory();
+    if (!directory.empty() &&
+        map((std::filesystem::path{directory} / normal).string()))
+      return true;
+    *text = source ? *source : embedded->source;
+    *identity = normal;
+    return true;
+  }
+
+  if (map(path))
+    return true;
+  std::cout << "ERROR: SHADER::FILE_NOT_SUCCESFULLY_READ " << path << ": "
+            << MappedFile{path}.error() << std::endl;
+  return false;
+}
+
+bool ShaderPreprocessor::expand(const std::string &path,
+                                const std::string_view *source,
+                                PreprocessedSource &out,
+                                const ShaderDefines *defines,
+                                std::vector<std::string> &active) {
+  std::string_view text;
+  std::string identity;
+  if (!open(path, source, out, &text, &identity))
+    return false;
+
+  auto emit = [&](std::string generated) {
+    out.segments.push_back(out.generated.emplace_back(std::move(generated)));
+  };
+
+  // a file that includes itself, directly or through others
+  if (std::find(active.begin(), active.end(), identity) != active.end())
+    return true;
+  active.push_back(identity);
+
+  // A repeated #include is expanded again and left to a guard, as the
+  // earlier one may sit in a branch of #if that is not taken. Only the GLSL
+  // compiler knows, so skipping it here could drop an active include.
+  auto known = std::find(out.files.begin(), out.files.end(), identity);
+  auto sourceIndex = static_cast<size_t>(known - out.files.begin());
+  if (known == out.files.end())
+    out.files.push_back(identity);
+  if (sourceIndex != 0) {
+    auto guard = "SHADER_INCLUDE_" + std::to_string(sourceIndex);
+    emit("#ifndef " + guard + "\n#define " + guard + "\n#line 1 " +
+         std::to_string(sourceIndex) + '\n');
+  }
+  auto directory = std::filesystem::path{path}.parent_path();
+  auto inject_defines = [&] {
+    std::string block;
+    for (auto &[name, value] : *defines)
+      block += "#define " + name + (value.empty() ? "" : " " + value) + '\n';
+    emit(std::move(block));
+  };
+  // only the main file receives the defines, ahead of its first line if
+  // there is no #version to put them behind
+  bool needDefines = defines && !defines->empty();
+  auto versionLine = version_line(text);
+  if (needDefines && versionLine == 0) {
+    inject_defines();
+    needDefines = false;
+  }
+
+  // text from `pending` up to the current line is copied as one segment
+  // once a line needs rewriting
+  auto pending = text.begin();
+  auto flush = [&](std::string_view::iterator end) {
+    if (end != pending)
+      out.segments.emplace_back(pending, end);
+  };
+
+  size_t lineNumber = 0;
+  std::string_view rest{text};
+  while (!rest.empty()) {
+    auto end = rest.find('\n');
+    auto line = rest.substr(0, end);
+    auto lineBegin = rest.begin();
+    auto lineEnd = end == std::string_view::npos ? rest.end()
+                                                 : rest.begin() + end + 1;
+    rest = std::string_view{lineEnd, rest.end()};
+    ++lineNumber;
+
+    if (lineNumber == versionLine) {
+      // an included file must not repeat the #version of the main file
+      if (sourceIndex != 0) {
+        flush(lineBegin);
+        emit("\n");
+        pending = lineEnd;
+      } else if (needDefines) {
+        flush(lineEnd);
+        if (lineEnd == text.end())
+          emit("\n");
+        inject_defines();
+        emit("#line " + std::to_string(lineNumber + 1) + " 0\n");
+        needDefines = false;
+        pending = lineEnd;
+      }
+      continue;
+    }
+
+    auto target = include_target(line);
+    if (target.empty())
+      continue;
+
+    flush(lineBegin);
+    pending = lineEnd;
+    auto included = (directory / target).string();
+    if (!expand(included, nullptr, out, nullptr, active)) {
+      std::cout << "  included from " << path << ':' << lineNumber
+                << std::endl;
+      return false;
+    }
+    emit("#line " + std::to_string(lineNumber + 1) + ' ' +
+         std::to_string(sourceIndex) + '\n');
+  }
+  flush(text.end());
+  // the included file may end without a newline
+  if (sourceIndex != 0)
+    emit("\n#endif\n");
+  active.pop_back();
+  return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "EmbeddedShaders.h"
+#include "MappedFile.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// #define name -> value, an empty value defines a flag. Ordered so that equal
+// sets always produce the same permutation key.
+using ShaderDefines = std::map<std::string, std::string>;
+
+// canonical text form of a define set, e.g. "LIGHT_CUBE;MIX=0.7"
+std::string permutationKey(const ShaderDefines &defines);
+
+// Preprocessed shader text as a list of segments for glShaderSource. The
+// segments point straight into the mapped or embedded source files, only
+// the injected directives are allocated, so the object is move-only.
+struct PreprocessedSource {
+  PreprocessedSource() = default;
+  PreprocessedSource(PreprocessedSource &&) = default;
+  PreprocessedSource &operator=(PreprocessedSource &&) = default;
+
+  std::vector<std::string_view> segments;
+  // every file that went into the segments, the main file first; the index
+  // is the source string number used in the emitted #line directives
+  std::vector<std::string> files;
+  bool ok{false};
+
+  // the whole text as one string, for tools and error reports
+  std::string str() const;
+
+  std::vector<std::unique_ptr<MappedFile>> mappings;
+  std::deque<std::string> generated;
+};
+
+// Drops comments and redundant whitespace. Line breaks are kept, so line
+// numbers in compiler errors and #line directives stay the same.
+std::string stripShaderSource(std::string_view text);
+
+// Expands `#include "file"` (relative to the including file, wrapped in a
+// guard so each file takes effect at most once) and injects the given
+// defines right after the #version line, so one source can be specialized
+// into several variants.
+class ShaderPreprocessor {
+public:
+  // `path` may also name a registered EmbeddedShaders file
+  static PreprocessedSource process(const std::string &path,
+                                    const ShaderDefines &defines = {});
+  static PreprocessedSource process(const EmbeddedFile &file,
+                                    const ShaderDefines &defines = {});
+
+private:
+  static bool open(const std::string &path, const std::string_view *source,
+                   PreprocessedSource &out, std::string_view *text,
+                   std::string *identity);
+  static bool expand(const std::string &path, const std::string_view *source,
+                     PreprocessedSource &out, const ShaderDefines *defines,
+                     std::vector<std::string> &active);
+};
+
+// A vertex/fragment pair and its defines, kept so a program can be built
+// again, e.g. by ShaderWatcher.
+struct ShaderSources {
+  std::string vertexPath;
+  std::string fragmentPath;
+  // texts of embedded files, only used when `embedded` is set
+  std::string_view vertexText;
+  std::string_view fragmentText;
+  bool embedded{false};
+  ShaderDefines defines;
+
+  // preprocess both stages, false if either failed
+  bool read(PreprocessedSource *vertexCode, PreprocessedSource *fragCode) const;
+};
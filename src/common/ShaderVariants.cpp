@@ -0,0 +1,14 @@
+#include "ShaderVariants.h"
+#include "ShaderLibrary.h"
+
+ShaderVariants::ShaderVariants(std::string vertexPath,
+                               std::string fragmentPath)
+    : mVertexPath(std::move(vertexPath)),
+      mFragmentPath(std::move(fragmentPath)) {}
+
+Shader &ShaderVariants::get(const ShaderDefines &defines) {
+  auto &variant = mVariants[permutationKey(defines)];
+  if (!variant)
+    variant = ShaderLibrary::get(mVertexPath, mFragmentPath, defines);
+  return *variant;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "ShaderPreprocessor.h"
+#include "shader.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Specialized programs built from one vertex/fragment source pair, one per
+// set of defines, e.g. lit vs. unlit. Each variant is compiled on first
+// request and reused afterwards; variants are taken from ShaderLibrary, so
+// they are shared with everyone else using the same sources.
+class ShaderVariants {
+public:
+  ShaderVariants(std::string vertexPath, std::string fragmentPath);
+
+  Shader &get(const ShaderDefines &defines = {});
+  size_t size() const { return mVariants.size(); }
+
+private:
+  std::string mVertexPath;
+  std::string mFragmentPath;
+  std::unordered_map<std::string, std::shared_ptr<Shader>> mVariants;
+};
@@ -0,0 +1,270 @@
+#include "ShaderWatcher.h"
+#include "shader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+struct Watched {
+  // distinguishes a shader from a later one at the same address
+  uint64_t serial;
+  // a copy, the watcher thread never touches the Shader itself
+  ShaderSources sources;
+  std::vector<std::string> files;
+};
+
+// preprocessed on the watcher thread, waiting for poll()
+struct Rebuild {
+  Shader *shader;
+  uint64_t serial;
+  PreprocessedSource vertex;
+  PreprocessedSource fragment;
+};
+
+struct State {
+  std::mutex mutex;
+  std::unordered_map<Shader *, Watched> shaders;
+  std::unordered_map<int, std::string> directories;
+  std::vector<Rebuild> ready;
+  uint64_t serial{0};
+
+  int fd{-1};
+  std::thread thread;
+  std::atomic<bool> stopping{false};
+};
+
+State &state() {
+  static State s;
+  return s;
+}
+
+// only touched by the render thread: replacements still compiling
+std::unordered_map<Shader *, std::unique_ptr<Shader>> &compiling() {
+  static std::unordered_map<Shader *, std::unique_ptr<Shader>> programs;
+  return programs;
+}
+
+// expects the lock to be held
+void watch_directories(State &s, const std::vector<std::string> &files) {
+  if (s.fd < 0)
+    return;
+  for (auto &file : files) {
+    // embedded sources have relative names and nothing on disk to watch
+    std::filesystem::path path{file};
+    if (!path.is_absolute())
+      continue;
+    // watch the directory, editors often save by renaming a new file
+    // over the old one
+    auto directory = path.parent_path().string();
+    auto known = std::find_if(
+        s.directories.begin(), s.directories.end(),
+        [&](auto &entry) { return entry.second == directory; });
+    if (known != s.directories.end())
+      continue;
+    int wd = inotify_add_watch(s.fd, directory.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+      std::cout << "ERROR::SHADER::WATCH " << directory << std::endl;
+      continue;
+    }
+    s.directories[wd] = directory;
+  }
+}
+
+// appends the files named by the pending events
+void read_events(State &s, std::vector<std::string> &changed) {
+  alignas(inotify_event) char buffer[4096];
+  for (;;) {
+    auto length = read(s.fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      return;
+    std::lock_guard lock{s.mutex};
+    for (char *p = buffer; p < buffer + length;) {
+      auto *event = reinterpret_cast<inotify_event *>(p);
+      auto directory = s.directories.find(event->wd);
+      if (event->len > 0 && directory != s.directories.end())
+        changed.push_back(directory->second + '/' + event->name);
+      p += sizeof(inotify_event) + event->len;
+    }
+  }
+}
+
+// The segments point into private mappings of files that are being edited
+// right now; a truncated file would fault when poll() reads them later.
+// Join them into one owned string before handing the source over.
+void own_text(PreprocessedSource &source) {
+  auto text = source.str();
+  source.segments.clear();
+  source.generated.clear();
+  source.mappings.clear();
+  source.segments.push_back(source.generated.emplace_back(std::move(text)));
+}
+
+void rebuild(State &s, const std::vector<std::string> &changed) {
+  struct Job {
+    Shader *shader;
+    uint64_t serial;
+    ShaderSources sources;
+  };
+  std::vector<Job> jobs;
+  {
+    std::lock_guard lock{s.mutex};
+    for (auto &[shader, watched] : s.shaders) {
+      auto affected = std::any_of(
+          watched.files.begin(), watched.files.end(), [&](auto &file) {
+            return std::find(changed.begin(), changed.end(), file) !=
+                   changed.end();
+          });
+      if (affected)
+        jobs.push_back({shader, watched.serial, watched.sources});
+    }
+  }
+
+  for (auto &job : jobs) {
+    Rebuild result{job.shader, job.serial, {}, {}};
+    if (!job.sources.read(&result.vertex, &result.fragment))
+      continue;
+    own_text(result.vertex);
+    own_text(result.fragment);
+    std::lock_guard lock{s.mutex};
+    // a shader that was destroyed meanwhile is dropped by poll()
+    std::erase_if(s.ready, [&](auto &r) { return r.shader == job.shader; });
+    s.ready.push_back(std::move(result));
+  }
+}
+
+void run(State &s) {
+  std::vector<std::string> changed;
+  while (!s.stopping) {
+    pollfd descriptor{s.fd, POLLIN, 0};
+    if (::poll(&descriptor, 1, 100) <= 0)
+      continue;
+    read_events(s, changed);
+    // editors write a file in several steps, let them finish
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    read_events(s, changed);
+
+    std::error_code error;
+    for (auto &file : changed) {
+      auto canonical = std::filesystem::weakly_canonical(file, error);
+      if (!error)
+        file = canonical.string();
+    }
+    rebuild(s, changed);
+    changed.clear();
+  }
+}
+} // namespace
+
+bool ShaderWatcher::start() {
+  auto &s = state();
+  if (s.fd >= 0)
+    return true;
+  s.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (s.fd < 0) {
+    std::cout << "ERROR::SHADER::WATCH inotify unavailable" << std::endl;
+    return false;
+  }
+  {
+    std::lock_guard lock{s.mutex};
+    for (auto &[shader, watched] : s.shaders)
+      watch_directories(s, watched.files);
+  }
+  s.stopping = false;
+  s.thread = std::thread{run, std::ref(s)};
+  return true;
+}
+
+void ShaderWatcher::stop() {
+  auto &s = state();
+  if (s.fd < 0)
+    return;
+  s.stopping = true;
+  s.thread.join();
+  close(s.fd);
+  s.fd = -1;
+  s.directories.clear();
+  s.ready.clear();
+  // the replacements unregister themselves while being destroyed
+  auto programs = std::move(compiling());
+  compiling().clear();
+}
+
+bool ShaderWatcher::running() { return state().fd >= 0; }
+
+void ShaderWatcher::poll() {
+  auto &s = state();
+  std::vector<Rebuild> ready;
+  {
+    std::lock_guard lock{s.mutex};
+    ready.swap(s.ready);
+    std::erase_if(ready, [&](auto &r) {
+      auto watched = s.shaders.find(r.shader);
+      return watched == s.shaders.end() || watched->second.serial != r.serial;
+    });
+  }
+
+  // submit the compiles; with GL_KHR_parallel_shader_compile they finish
+  // in the background and the old program keeps drawing meanwhile
+  for (auto &r : ready) {
+    std::cout << "SHADER::RELOAD " << r.vertex.files[0] << ", "
+              << r.fragment.files[0] << std::endl;
+    compiling()[r.shader].reset(new Shader{r.vertex, r.fragment});
+
+    // the edit may have added or removed #includes
+    auto files = r.vertex.files;
+    files.insert(files.end(), r.fragment.files.begin(),
+                 r.fragment.files.end());
+    std::lock_guard lock{s.mutex};
+    watch_directories(s, files);
+    s.shaders[r.shader].files = std::move(files);
+  }
+
+  for (auto it = compiling().begin(); it != compiling().end();) {
+    if (!it->second->link_finished()) {
+      ++it;
+      continue;
+    }
+    auto *shader = it->first;
+    auto next = std::move(it->second);
+    it = compiling().erase(it);
+    if (next->mState == Shader::State::Linked)
+      shader->adopt(*next);
+    else
+      std::cout << "ERROR::SHADER::RELOAD_FAILED keeping the previous program"
+                << std::endl;
+  }
+}
+
+void ShaderWatcher::add(Shader *shader, const ShaderSources &sources,
+                        std::vector<std::string> files) {
+  auto &s = state();
+  std::lock_guard lock{s.mutex};
+  watch_directories(s, files);
+  auto &watched = s.shaders[shader];
+  watched.serial = ++s.serial;
+  watched.sources = sources;
+  watched.files = std::move(files);
+}
+
+void ShaderWatcher::remove(Shader *shader) {
+  auto &s = state();
+  {
+    std::lock_guard lock{s.mutex};
+    s.shaders.erase(shader);
+  }
+  auto it = compiling().find(shader);
+  if (it != compiling().end()) {
+    auto next = std::move(it->second);
+    compiling().erase(it);
+  }
+}
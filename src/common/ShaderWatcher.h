@@ -0,0 +1,27 @@
+#pragma once
+#include "ShaderPreprocessor.h"
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Hot reload for live Shaders. A background thread watches the directories
+// of every source file (includes too) with inotify and preprocesses the
+// sources of affected shaders again; poll() then compiles them on the
+// render thread and swaps the new program in once it has linked. When the
+// new version fails to compile, the old program stays in use.
+class ShaderWatcher {
+public:
+  // start watching, false when inotify is unavailable
+  static bool start();
+  static void stop();
+  static bool running();
+  // call once per frame on the render thread, before drawing
+  static void poll();
+
+private:
+  friend class Shader;
+  static void add(Shader *shader, const ShaderSources &sources,
+                  std::vector<std::string> files);
+  static void remove(Shader *shader);
+};
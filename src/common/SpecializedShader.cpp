@@ -0,0 +1,98 @@
+#include "SpecializedShader.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace {
+// inf and nan can't be written in GLSL, those stay uniforms
+bool has_literal(const SpecializedShader::Value &value) {
+  auto *f = std::get_if<float>(&value);
+  return !f || std::isfinite(*f);
+}
+
+// GLSL literal for a constant, floats always keep a '.' or an exponent
+std::string glsl_literal(const SpecializedShader::Value &value) {
+  if (auto *b = std::get_if<bool>(&value))
+    return *b ? "true" : "false";
+  if (auto *i = std::get_if<int>(&value))
+    return std::to_string(*i);
+
+  char buffer[32];
+  auto result =
+      std::to_chars(buffer, buffer + sizeof(buffer), std::get<float>(value));
+  std::string literal{buffer, result.ptr};
+  if (literal.find_first_of(".eE") == std::string::npos)
+    literal += ".0";
+  return literal;
+}
+} // namespace
+
+SpecializedShader::SpecializedShader(std::string vertexPath,
+                                     std::string fragmentPath,
+                                     ShaderDefines defines)
+    : mVertexPath(std::move(vertexPath)),
+      mFragmentPath(std::move(fragmentPath)), mDefines(std::move(defines)) {
+  // only worth compiling up front when it can draw while the specialized
+  // programs link in the background
+  glext::load();
+  if (glext::hasParallelShaderCompile())
+    generic();
+}
+
+Shader &SpecializedShader::generic() {
+  if (!mGeneric)
+    mGeneric = ShaderLibrary::get(mVertexPath, mFragmentPath, mDefines);
+  return *mGeneric;
+}
+
+void SpecializedShader::setConstant(const std::string &name, Value value) {
+  auto it = mConstants.find(name);
+  if (it != mConstants.end() && it->second == value)
+    return;
+  mConstants[name] = value;
+  auto literal = [](auto &constant) { return has_literal(constant.second); };
+  if (!std::all_of(mConstants.begin(), mConstants.end(), literal)) {
+    mSpecialized = nullptr;
+    return;
+  }
+
+  auto defines = mDefines;
+  for (auto &[constant, constantValue] : mConstants)
+    defines[constant] = glsl_literal(constantValue);
+  // only submitted here; a combination built before is still finished
+  auto &program = mPrograms[permutationKey(defines)];
+  if (!program)
+    program = ShaderLibrary::get(mVertexPath, mFragmentPath, defines);
+  mSpecialized = program;
+}
+
+bool SpecializedShader::specialized() const {
+  return mSpecialized && mSpecialized->isReady();
+}
+
+Shader &SpecializedShader::use() {
+  if (specialized()) {
+    mSpecialized->use();
+    return *mSpecialized;
+  }
+
+  auto &shader = generic();
+  shader.use();
+  // unchanged values are skipped by the shadow copy
+  for (auto &[name, value] : mConstants) {
+    auto handle = shader.getUniformHandle(name);
+    std::visit(
+        [&](auto v) {
+          using T = decltype(v);
+          if constexpr (std::is_same_v<T, bool>)
+            shader.setBool(handle, v);
+          else if constexpr (std::is_same_v<T, int>)
+            shader.setInt(handle, v);
+          else
+            shader.setFloat(handle, v);
+        },
+        value);
+  }
+  return shader;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "ShaderLibrary.h"
+#include "ShaderPreprocessor.h"
+#include "shader.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <variant>
+
+// Emulates specialization constants: a constant is declared in GLSL as a
+// uniform that a #define of the same name can replace,
+//
+//   #ifndef mixFactor
+//   uniform float mixFactor;
+//   #endif
+//
+// The specialized program gets `#define mixFactor 0.7` and lets the compiler
+// fold the value; the generic program reads the uniform. use() binds the
+// specialized program once it has linked and falls back to the generic one,
+// fed with the same values, while it is compiling. Without
+// GL_KHR_parallel_shader_compile use() waits for the link instead and the
+// generic program is only built when it is needed: for values without a
+// GLSL literal (inf, nan) or when the specialized program fails to link.
+// Every specialized program is kept for the lifetime of this object, so
+// going back to earlier values doesn't compile again; keep the set of
+// values small.
+class SpecializedShader {
+public:
+  using Value = std::variant<bool, int, float>;
+
+  SpecializedShader(std::string vertexPath, std::string fragmentPath,
+                    ShaderDefines defines = {});
+
+  // takes effect at the next use(); a new value starts compiling another
+  // specialized program
+  void setConstant(const std::string &name, Value value);
+  const std::map<std::string, Value> &getConstants() const {
+    return mConstants;
+  }
+
+  // bind the best program available and return it for setting the other
+  // uniforms
+  Shader &use();
+  // whether use() currently picks the specialized program
+  bool specialized() const;
+
+private:
+  std::string mVertexPath;
+  std::string mFragmentPath;
+  ShaderDefines mDefines;
+  std::map<std::string, Value> mConstants;
+  // built on first use unless links can be polled, see generic()
+  std::shared_ptr<Shader> mGeneric;
+  // by permutationKey(), ShaderLibrary itself only keeps weak references
+  std::map<std::string, std::shared_ptr<Shader>> mPrograms;
+  std::shared_ptr<Shader> mSpecialized;
+
+  Shader &generic();
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include "GLExtensions.h"
+#include "common.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Shader storage buffer holding an array of T, for per-object data too big
+// for uniforms (transforms, colors, material indices of many objects):
+//
+//   struct Object { glm::mat4 model; glm::vec4 color; };
+//   layout (std430, binding = 2) buffer Objects { Object objects[]; };
+//
+// T has to follow std430: vec3 members padded to 16 bytes. Needs GL 4.3
+// or ARB_shader_storage_buffer_object, check supported() first.
+// Shader::bindStorageBlock connects programs to the binding point, see
+// attach().
+template <typename T> class StorageBuffer {
+public:
+  StorageBuffer(std::string name, GLuint bindingPoint, size_t capacity = 1)
+      : mName{std::move(name)}, mBindingPoint{bindingPoint} {
+    glGenBuffers(1, &mSsbo);
+    // an empty buffer can't be bound, keep room for at least one element
+    allocate(std::max<size_t>(capacity, 1));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, mBindingPoint, mSsbo);
+  }
+  StorageBuffer(const StorageBuffer &) = delete;
+  StorageBuffer &operator=(const StorageBuffer &) = delete;
+  ~StorageBuffer() {
+    if (glfwGetCurrentContext())
+      glDeleteBuffers(1, &mSsbo);
+  }
+
+  static bool supported() {
+    glext::load();
+    return glext::hasShaderStorageBuffers();
+  }
+
+  const std::string &name() const { return mName; }
+  GLuint bindingPoint() const { return mBindingPoint; }
+  size_t size() const { return mSize; }
+  size_t capacity() const { return mCapacity; }
+
+  // bind the shader's storage block of the same name to this buffer
+  template <typename S> bool attach(S &shader) const {
+    return shader.bindStorageBlock(mName, mBindingPoint);
+  }
+
+  // grow the storage, the contents are lost when it is reallocated
+  void reserve(size_t capacity) {
+    if (capacity > mCapacity)
+      allocate(capacity);
+  }
+
+  // replace the whole array in one upload
+  void assign(std::span<const T> data) {
+    if (data.size() > mCapacity)
+      reserve(data.size());
+    mSize = data.size();
+    update(data, 0);
+  }
+
+  // overwrite `data.size()` elements starting at `first`, within size()
+  void update(std::span<const T> data, size_t first = 0) {
+    if (data.empty() || first + data.size() > mSize)
+      return;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSsbo);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                    static_cast<GLintptr>(sizeof(T) * first),
+                    static_cast<GLsizeiptr>(data.size_bytes()), data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+private:
+  void allocate(size_t capacity) {
+    mCapacity = capacity;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSsbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 static_cast<GLsizeiptr>(sizeof(T) * capacity), nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  std::string mName;
+  GLuint mBindingPoint;
+  unsigned int mSsbo{0};
+  size_t mSize{0};
+  size_t mCapacity{0};
+};
@@ -1,38 +1,247 @@
 #include "Texture2D.h"
+#include "GLExtensions.h"
+#include "TextureLoader.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
 #define STB_IMAGE_IMPLEMENTATION
-#include "glad/glad.h"
 #include "stb_image.h"
-#include <GL/gl.h>
 #include <GLFW/glfw3.h>
 
-Texture2D::Texture2D(const std::string &path) : mPath(path) {
-  int image_w, image_h, image_nCh;
+namespace {
+using Clock = std::chrono::steady_clock;
+double elapsed_ms(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+GLenum channel_format(int channels) {
+  switch (channels) {
+  case 1:
+    return GL_RED;
+  case 2:
+    return GL_RG;
+  case 4:
+    return GL_RGBA;
+  default:
+    return GL_RGB;
+  }
+}
+
+// sized internal format for the uploaded components; sRGB only applies to
+// color images
+GLenum internal_format(int channels, bool srgb) {
+  switch (channels) {
+  case 1:
+    return GL_R8;
+  case 2:
+    return GL_RG8;
+  case 4:
+    return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+  default:
+    return srgb ? GL_SRGB8 : GL_RGB8;
+  }
+}
 
-  std::cout << "Print load image: " << path << std::endl;
-  stbi_set_flip_vertically_on_load(true);
-  auto *imageData = stbi_load(path.c_str(), &image_w, &image_h, &image_nCh, 0);
+// grey images sample as grey rather than red, grey + alpha keeps its alpha
+void set_swizzle(int channels) {
+  if (channels == 1) {
+    const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+  } else if (channels == 2) {
+    const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+  }
+}
+
+// RGB to RGBA with an opaque alpha, in memory stbi_image_free() accepts
+unsigned char *pad_to_rgba(const unsigned char *rgb, size_t pixelCount) {
+  auto *rgba = static_cast<unsigned char *>(STBI_MALLOC(pixelCount * 4));
+  if (!rgba)
+    return nullptr;
+  for (size_t i = 0; i < pixelCount; ++i) {
+    rgba[i * 4 + 0] = rgb[i * 3 + 0];
+    rgba[i * 4 + 1] = rgb[i * 3 + 1];
+    rgba[i * 4 + 2] = rgb[i * 3 + 2];
+    rgba[i * 4 + 3] = 255;
+  }
+  return rgba;
+}
+
+bool uses_mipmaps(GLint minFilter) {
+  return minFilter != GL_NEAREST && minFilter != GL_LINEAR;
+}
 
-  mWidth = image_w;
-  mHeight = image_h;
+// levels down to 1x1
+int32_t full_mip_count(int32_t width, int32_t height) {
+  auto size = static_cast<uint32_t>(std::max(width, height));
+  return static_cast<int32_t>(std::bit_width(size));
+}
+} // namespace
+
+std::string assetPath(std::string_view name) {
+  static const std::string directory = [] {
+    const char *env = std::getenv("ASSET_DIR");
+    return std::string{env ? env : ASSET_DIR};
+  }();
+  return directory + '/' + std::string{name};
+}
+
+void TextureImage::Free::operator()(unsigned char *pixels) const {
+  stbi_image_free(pixels);
+}
+
+TextureImage TextureImage::load(const std::string &path) {
+  TextureImage image;
+  auto start = Clock::now();
+  // the flag is per thread, workers decode concurrently
+  stbi_set_flip_vertically_on_load_thread(true);
+  image.pixels.reset(stbi_load(path.c_str(), &image.width, &image.height,
+                               &image.fileChannels, 0));
+  if (!image.pixels) {
+    image.error = stbi_failure_reason();
+    image.decodeMs = elapsed_ms(start);
+    return image;
+  }
+  image.channels = image.fileChannels;
+  if (image.channels == 3) {
+    auto pixelCount = static_cast<size_t>(image.width) *
+                      static_cast<size_t>(image.height);
+    image.pixels.reset(pad_to_rgba(image.pixels.get(), pixelCount));
+    image.channels = 4;
+    if (!image.pixels)
+      image.error = "out of memory";
+  }
+  image.decodeMs = elapsed_ms(start);
+  return image;
+}
+
+Texture2D::Texture2D(const std::string &path, const TextureSampling &sampling)
+    : mPath(path), mSampling(sampling) {
+  auto image = TextureImage::load(path);
+  upload(image, image.pixels.get());
+}
+
+std::shared_ptr<Texture2D> Texture2D::loadAsync(const std::string &path,
+                                                const TextureSampling &sampling) {
+  return TextureLoader::load(path, sampling);
+}
+
+void Texture2D::upload(const TextureImage &image, const void *pixels) {
+  mPending = false;
+  mLoadStats.decodeMs = image.decodeMs;
+  if (!image.error.empty()) {
+    std::cout << "ERROR::TEXTURE::FILE_NOT_SUCCESFULLY_READ " << mPath << ": "
+              << image.error << std::endl;
+    return;
+  }
+
+  mWidth = image.width;
+  mHeight = image.height;
+  mChannels = image.channels;
+  mMipLevels = uses_mipmaps(mSampling.minFilter)
+                   ? full_mip_count(mWidth, mHeight)
+                   : 1;
+  auto start = Clock::now();
+  glext::load();
   glGenTextures(1, &mTextureID);
   glBindTexture(GL_TEXTURE_2D, mTextureID);
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, mSampling.wrapS);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, mSampling.wrapT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mSampling.minFilter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mSampling.magFilter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mMipLevels - 1);
+  set_swizzle(mChannels);
+
+  // rows of 1 and 2 component images needn't be 4 byte aligned
+  auto rowBytes = static_cast<size_t>(mWidth) * static_cast<size_t>(mChannels);
+  bool packed = rowBytes % 4 != 0;
+  if (packed)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, mWidth, mHeight, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, imageData);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  stbi_image_free(imageData);
+  auto format = channel_format(mChannels);
+  auto internal = internal_format(mChannels, mSampling.srgb);
+  if (glext::hasTextureStorage()) {
+    // immutable: allocated once with the whole mip chain
+    glext::glTexStorage2D(GL_TEXTURE_2D, mMipLevels, internal, mWidth,
+                          mHeight);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight, format,
+                    GL_UNSIGNED_BYTE, pixels);
+  } else {
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(internal), mWidth,
+                 mHeight, 0, format, GL_UNSIGNED_BYTE, pixels);
+  }
+  if (mMipLevels > 1)
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+  if (packed)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
   glBindTexture(GL_TEXTURE_2D, 0);
+  mLoadStats.uploadMs = elapsed_ms(start);
+
+  std::cout << "Loaded texture " << mPath << " (" << mWidth << 'x' << mHeight
+            << ", " << image.fileChannels << " channels, " << mMipLevels
+            << " levels) decode "
+            << mLoadStats.decodeMs << " ms, upload " << mLoadStats.uploadMs
+            << " ms" << std::endl;
+}
+
+Texture2D::Texture2D(Texture2D &&other) noexcept
+    : mPath(std::move(other.mPath)), mWidth(other.mWidth),
+      mHeight(other.mHeight), mChannels(other.mChannels),
+      mMipLevels(other.mMipLevels), mSampling(other.mSampling),
+      mTextureID(std::exchange(other.mTextureID, 0u)),
+      mPending(other.mPending),
+      mLoadStats(other.mLoadStats) {}
+
+Texture2D &Texture2D::operator=(Texture2D &&other) noexcept {
+  if (this != &other) {
+    release();
+    mPath = std::move(other.mPath);
+    mWidth = other.mWidth;
+    mHeight = other.mHeight;
+    mChannels = other.mChannels;
+    mMipLevels = other.mMipLevels;
+    mSampling = other.mSampling;
+    mTextureID = std::exchange(other.mTextureID, 0u);
+    mPending = other.mPending;
+    mLoadStats = other.mLoadStats;
+  }
+  return *this;
 }
 
-void Texture2D::bind() const { glBindTexture(GL_TEXTURE_2D, mTextureID); }
+Texture2D::~Texture2D() { release(); }
+
+void Texture2D::release() {
+  // the context may already be gone when a texture outlives the window
+  if (mTextureID != 0 && glfwGetCurrentContext())
+    glDeleteTextures(1, &mTextureID);
+  mTextureID = 0;
+}
+
+size_t Texture2D::getByteSize() const {
+  if (!isValid())
+    return 0;
+  auto level = static_cast<size_t>(mWidth) * static_cast<size_t>(mHeight) *
+               static_cast<size_t>(mChannels);
+  // a full mip chain adds a third
+  return mMipLevels > 1 ? level + level / 3 : level;
+}
+
+void Texture2D::bind() const {
+  glBindTexture(GL_TEXTURE_2D,
+                mPending ? TextureLoader::placeholder() : mTextureID);
+}
+
+void Texture2D::bind(unsigned int unit) const {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  bind();
+}
 
 void Texture2D::unbind() const { glBindTexture(GL_TEXTURE_2D, 0); }
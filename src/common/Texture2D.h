@@ -1,21 +1,110 @@
+#pragma once
+#include "common.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 
+// Path of an image file below the asset directory: $ASSET_DIR when set,
+// otherwise the assets/ folder of the source tree the program was built from.
+std::string assetPath(std::string_view name);
+
+// Wrapping, filtering and color space of a texture, part of the
+// TextureCache key.
+struct TextureSampling {
+  GLint wrapS{GL_REPEAT};
+  GLint wrapT{GL_REPEAT};
+  GLint minFilter{GL_LINEAR_MIPMAP_LINEAR};
+  GLint magFilter{GL_LINEAR};
+  // color data stored as sRGB, linearized when sampled
+  bool srgb{false};
+
+  bool operator==(const TextureSampling &) const = default;
+};
+
+// Pixels decoded from an image file. Decoding needs no GL context, so it
+// may run on any thread. RGB images are padded to RGBA, which is how
+// drivers store them anyway, so the upload needn't be repacked.
+struct TextureImage {
+  struct Free {
+    void operator()(unsigned char *pixels) const;
+  };
+  std::unique_ptr<unsigned char, Free> pixels;
+  int32_t width{0};
+  int32_t height{0};
+  // components per pixel in `pixels`
+  int32_t channels{0};
+  // components in the file, 3 for a padded RGB image
+  int32_t fileChannels{0};
+  double decodeMs{0.0};
+  // why decoding failed, empty on success
+  std::string error;
+
+  static TextureImage load(const std::string &path);
+  size_t bytes() const {
+    return static_cast<size_t>(width) * static_cast<size_t>(height) *
+           static_cast<size_t>(channels);
+  }
+};
+
+// A 2D texture loaded from an image file. The image is decoded and uploaded
+// exactly once; if decoding fails no GL object is created, isValid() is
+// false and bind() binds no texture.
 class Texture2D {
+  friend class TextureLoader;
 
 public:
   Texture2D() = default;
-  Texture2D(const std::string &path);
-  ~Texture2D(){};
+  explicit Texture2D(const std::string &path,
+                     const TextureSampling &sampling = {});
+  Texture2D(const Texture2D &) = delete;
+  Texture2D &operator=(const Texture2D &) = delete;
+  Texture2D(Texture2D &&other) noexcept;
+  Texture2D &operator=(Texture2D &&other) noexcept;
+  ~Texture2D();
+
+  // decode on TextureLoader's workers and upload during a later
+  // TextureLoader::poll(); bind() binds a placeholder until then
+  static std::shared_ptr<Texture2D>
+  loadAsync(const std::string &path, const TextureSampling &sampling = {});
+  bool isPending() const { return mPending; }
 
+  bool isValid() const { return mTextureID != 0; }
+  uint32_t getId() const { return mTextureID; }
+  const std::string &getPath() const { return mPath; }
   int32_t getWidth() const { return mWidth; }
   int32_t getHeight() const { return mHeight; }
+  int32_t getChannels() const { return mChannels; }
+  const TextureSampling &getSampling() const { return mSampling; }
+  int32_t getMipLevels() const { return mMipLevels; }
+  // estimated video memory, including the mip chain
+  size_t getByteSize() const;
+
+  struct LoadStats {
+    double decodeMs{0.0};
+    double uploadMs{0.0};
+  };
+  LoadStats getLoadStats() const { return mLoadStats; }
 
   void bind() const;
+  // bind to texture unit `unit`, which becomes the active unit
+  void bind(unsigned int unit) const;
   void unbind() const;
 
 private:
+  // `pixels` is client memory, or an offset into the bound
+  // GL_PIXEL_UNPACK_BUFFER
+  void upload(const TextureImage &image, const void *pixels);
+  void release();
+
   std::string mPath;
-  int32_t mWidth;
-  int32_t mHeight;
-  uint32_t mTextureID;
-};
\ No newline at end of file
+  int32_t mWidth{0};
+  int32_t mHeight{0};
+  int32_t mChannels{0};
+  int32_t mMipLevels{0};
+  TextureSampling mSampling;
+  uint32_t mTextureID{0};
+  // queued with TextureLoader, not uploaded yet
+  bool mPending{false};
+  LoadStats mLoadStats;
+};
@@ -0,0 +1,115 @@
+#include "TextureCache.h"
+#include <filesystem>
+#include <list>
+#include <unordered_map>
+
+namespace {
+struct Entry {
+  std::shared_ptr<Texture2D> texture;
+  size_t bytes{0};
+  // position in the LRU list, most recently requested last
+  std::list<std::string>::iterator lru;
+};
+
+struct Cache {
+  std::unordered_map<std::string, Entry> entries;
+  std::list<std::string> lru;
+  // 256 MiB
+  size_t budget{size_t{256} << 20};
+  TextureCache::Stats stats;
+};
+
+Cache &cache() {
+  static Cache instance;
+  return instance;
+}
+
+std::string texture_key(const std::string &path,
+                        const TextureSampling &sampling) {
+  std::error_code error;
+  auto canonical = std::filesystem::weakly_canonical(path, error);
+  auto key = error ? std::filesystem::path{path}.lexically_normal().string()
+                   : canonical.string();
+  for (auto value : {sampling.wrapS, sampling.wrapT, sampling.minFilter,
+                     sampling.magFilter})
+    key += '\n' + std::to_string(value);
+  if (sampling.srgb)
+    key += "\nsrgb";
+  return key;
+}
+
+// the cache holds the only reference
+bool unused(const Entry &entry) { return entry.texture.use_count() == 1; }
+
+void evict(Cache &c, std::unordered_map<std::string, Entry>::iterator it) {
+  c.stats.bytes -= it->second.bytes;
+  c.lru.erase(it->second.lru);
+  c.entries.erase(it);
+}
+} // namespace
+
+std::shared_ptr<Texture2D> TextureCache::get(const std::string &path,
+                                             const TextureSampling &sampling) {
+  auto &c = cache();
+  auto key = texture_key(path, sampling);
+  if (auto it = c.entries.find(key); it != c.entries.end()) {
+    ++c.stats.hits;
+    c.lru.splice(c.lru.end(), c.lru, it->second.lru);
+    return it->second.texture;
+  }
+
+  ++c.stats.misses;
+  auto texture = std::make_shared<Texture2D>(path, sampling);
+  if (!texture->isValid())
+    return texture;
+
+  Entry entry{texture, texture->getByteSize(), c.lru.insert(c.lru.end(), key)};
+  c.stats.bytes += entry.bytes;
+  c.entries.emplace(std::move(key), std::move(entry));
+  trim();
+  return texture;
+}
+
+void TextureCache::setBudget(size_t bytes) {
+  cache().budget = bytes;
+  trim();
+}
+
+size_t TextureCache::getBudget() { return cache().budget; }
+
+size_t TextureCache::trim() {
+  auto &c = cache();
+  size_t released = 0;
+  for (auto key = c.lru.begin();
+       c.stats.bytes > c.budget && key != c.lru.end();) {
+    auto it = c.entries.find(*key++);
+    if (!unused(it->second))
+      continue;
+    evict(c, it);
+    ++released;
+  }
+  c.stats.evictions += static_cast<unsigned int>(released);
+  return released;
+}
+
+void TextureCache::clear() {
+  auto &c = cache();
+  for (auto it = c.entries.begin(); it != c.entries.end();) {
+    auto next = std::next(it);
+    if (unused(it->second))
+      evict(c, it);
+    it = next;
+  }
+}
+
+TextureCache::Stats TextureCache::getStats() {
+  auto stats = cache().stats;
+  stats.entries = cache().entries.size();
+  return stats;
+}
+
+void TextureCache::resetStats() {
+  auto &stats = cache().stats;
+  // the resident size isn't a counter
+  stats = {0, 0, 0, 0, stats.bytes};
+}
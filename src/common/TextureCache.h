@@ -0,0 +1,35 @@
+#pragma once
+#include "Texture2D.h"
+#include <memory>
+#include <string>
+
+// Shares one Texture2D between everyone asking for the same image file
+// (by canonical path) and sampling, so repeated loads don't decode and
+// upload it again. Textures nobody holds anymore stay cached until the
+// estimated video memory of the cache exceeds the budget; then the least
+// recently requested ones are released first.
+class TextureCache {
+public:
+  // an invalid texture if the image can't be loaded; failures aren't cached
+  static std::shared_ptr<Texture2D> get(const std::string &path,
+                                        const TextureSampling &sampling = {});
+
+  static void setBudget(size_t bytes);
+  static size_t getBudget();
+  // release unused textures until the cache fits the budget, returns how
+  // many were released
+  static size_t trim();
+  // release every unused texture, e.g. before the context goes away
+  static void clear();
+
+  struct Stats {
+    unsigned int hits{0};
+    unsigned int misses{0};
+    unsigned int evictions{0};
+    // textures cached and their estimated video memory
+    size_t entries{0};
+    size_t bytes{0};
+  };
+  static Stats getStats();
+  static void resetStats();
+};
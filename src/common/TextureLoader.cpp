@@ -0,0 +1,232 @@
+#include "TextureLoader.h"
+#include "PixelBufferRing.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <GLFW/glfw3.h>
+
+namespace {
+struct Job {
+  std::weak_ptr<Texture2D> texture;
+  std::string path;
+};
+
+// decoded on a worker, waiting for poll()
+struct Decoded {
+  std::weak_ptr<Texture2D> texture;
+  TextureImage image;
+  // staging slot holding the pixels, -1 when they are in `image`
+  int slot{-1};
+};
+
+// 3 x 16 MiB fits a 2048x2048 RGBA image per slot
+constexpr size_t STAGING_SLOTS = 3;
+constexpr size_t STAGING_SLOT_BYTES = size_t{16} << 20;
+
+struct State {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<Job> queue;
+  std::deque<Decoded> ready;
+  // jobs taken by a worker and not yet in `ready`
+  size_t decoding{0};
+  bool stopping{false};
+  std::vector<std::thread> workers;
+  GLuint placeholder{0};
+  // created by poll() while loads are in flight and dropped once they are
+  // all uploaded; never while a worker or `ready` may refer to its slots
+  std::unique_ptr<PixelBufferRing> staging;
+  size_t stagingSlots{STAGING_SLOTS};
+  size_t stagingSlotBytes{STAGING_SLOT_BYTES};
+
+  ~State() {
+    join();
+    drop_staging();
+  }
+
+  void drop_staging() {
+    // the buffers went with the context when it is gone already
+    if (staging && !glfwGetCurrentContext())
+      (void)staging.release();
+    staging.reset();
+  }
+
+  void join() {
+    {
+      std::lock_guard lock{mutex};
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+    workers.clear();
+    stopping = false;
+  }
+};
+
+State &state() {
+  static State s;
+  return s;
+}
+
+void work(State &s) {
+  std::unique_lock lock{s.mutex};
+  while (true) {
+    s.wake.wait(lock, [&] { return s.stopping || !s.queue.empty(); });
+    if (s.stopping)
+      return;
+    auto job = std::move(s.queue.front());
+    s.queue.pop_front();
+    // nobody waits for it anymore
+    if (job.texture.expired())
+      continue;
+    ++s.decoding;
+
+    auto *staging = s.staging.get();
+    lock.unlock();
+    auto image = TextureImage::load(job.path);
+    // copy into a mapped unpack buffer so the upload needn't read client
+    // memory; without a free slot the upload falls back to the pixels
+    int slot = -1;
+    if (staging && image.pixels)
+      slot = staging->acquire(image.bytes());
+    if (slot >= 0) {
+      std::memcpy(staging->memory(slot), image.pixels.get(), image.bytes());
+      image.pixels.reset();
+    }
+    lock.lock();
+
+    --s.decoding;
+    s.ready.push_back({std::move(job.texture), std::move(image), slot});
+  }
+}
+
+// expects the lock to be held
+bool idle(const State &s) {
+  return s.queue.empty() && s.decoding == 0 && s.ready.empty();
+}
+
+// expects the lock to be held
+void start_workers(State &s) {
+  if (!s.workers.empty())
+    return;
+  // leave a core to the render thread
+  auto count = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+  for (unsigned int i = 0; i < count; ++i)
+    s.workers.emplace_back(work, std::ref(s));
+}
+} // namespace
+
+std::shared_ptr<Texture2D> TextureLoader::load(const std::string &path,
+                                               const TextureSampling &sampling) {
+  std::shared_ptr<Texture2D> texture{new Texture2D};
+  texture->mPath = path;
+  texture->mSampling = sampling;
+  texture->mPending = true;
+
+  auto &s = state();
+  {
+    std::lock_guard lock{s.mutex};
+    start_workers(s);
+    s.queue.push_back({texture, path});
+  }
+  s.wake.notify_one();
+  return texture;
+}
+
+void TextureLoader::poll(double budgetMs) {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  auto &s = state();
+  PixelBufferRing *staging;
+  {
+    std::lock_guard lock{s.mutex};
+    if (idle(s)) {
+      // nothing to load, don't hold on to the staging memory
+      s.drop_staging();
+      return;
+    }
+    if (!s.staging && s.stagingSlots > 0)
+      s.staging = std::make_unique<PixelBufferRing>(s.stagingSlots,
+                                                    s.stagingSlotBytes);
+    staging = s.staging.get();
+  }
+  if (staging)
+    staging->reclaim();
+
+  do {
+    Decoded next;
+    {
+      std::lock_guard lock{s.mutex};
+      if (s.ready.empty())
+        return;
+      next = std::move(s.ready.front());
+      s.ready.pop_front();
+    }
+    auto texture = next.texture.lock();
+    if (next.slot < 0) {
+      if (texture)
+        texture->upload(next.image, next.image.pixels.get());
+      continue;
+    }
+    if (!texture) {
+      staging->release(next.slot);
+      continue;
+    }
+    // the transfer runs from the buffer while the next images decode, the
+    // fence keeps the slot from being reused before it is done
+    staging->bind(next.slot);
+    texture->upload(next.image, nullptr);
+    staging->submit(next.slot);
+  } while (std::chrono::duration<double, std::milli>(Clock::now() - start)
+               .count() < budgetMs);
+}
+
+size_t TextureLoader::pending() {
+  auto &s = state();
+  std::lock_guard lock{s.mutex};
+  return s.queue.size() + s.decoding + s.ready.size();
+}
+
+void TextureLoader::stop() {
+  auto &s = state();
+  s.join();
+  std::lock_guard lock{s.mutex};
+  s.queue.clear();
+  s.ready.clear();
+  s.drop_staging();
+  if (s.placeholder != 0 && glfwGetCurrentContext())
+    glDeleteTextures(1, &s.placeholder);
+  s.placeholder = 0;
+}
+
+void TextureLoader::setStaging(size_t slotCount, size_t slotBytes) {
+  auto &s = state();
+  std::lock_guard lock{s.mutex};
+  s.stagingSlots = slotCount;
+  s.stagingSlotBytes = slotBytes;
+  // a busy ring is replaced by the first poll() after the loads finish
+  if (idle(s))
+    s.drop_staging();
+}
+
+GLuint TextureLoader::placeholder() {
+  auto &s = state();
+  if (s.placeholder != 0)
+    return s.placeholder;
+
+  const unsigned char pixels[] = {96,  96,  96,  255, 160, 160, 160, 255,
+                                  160, 160, 160, 255, 96,  96,  96,  255};
+  glGenTextures(1, &s.placeholder);
+  glBindTexture(GL_TEXTURE_2D, s.placeholder);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels);
+  return s.placeholder;
+}
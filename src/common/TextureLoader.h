@@ -0,0 +1,30 @@
+#pragma once
+#include "Texture2D.h"
+#include <memory>
+#include <string>
+
+// Loads textures without stalling the render thread. Images are decoded on
+// a pool of worker threads; poll() uploads the decoded ones on the render
+// thread, stopping once the frame's time budget is spent. Until its upload
+// a texture binds a placeholder.
+class TextureLoader {
+public:
+  // the returned texture is pending until a poll() uploads it
+  static std::shared_ptr<Texture2D>
+  load(const std::string &path, const TextureSampling &sampling = {});
+  // call once per frame on the render thread; uploads at least one decoded
+  // image, more while less than `budgetMs` has been spent
+  static void poll(double budgetMs = 2.0);
+  // textures queued, decoding or waiting for upload
+  static size_t pending();
+  // join the workers and drop the loads still outstanding
+  static void stop();
+
+  // unpack buffer ring used to stage decoded images, 3 x 16 MiB by default;
+  // 0 slots uploads from client memory. Render thread only; applies once no
+  // load is in flight.
+  static void setStaging(size_t slotCount, size_t slotBytes);
+
+  // 2x2 grey checker, bound in place of textures that are still loading
+  static GLuint placeholder();
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "common.h"
+#include "UniformTable.h"
+#include <array>
+#include <glm/glm.hpp>
+#include <string_view>
+
+// GL type glGetActiveUniform reports for a uniform set from a T
+template <typename T> struct UniformType;
+template <> struct UniformType<bool> {
+  static constexpr GLenum value = GL_BOOL;
+};
+template <> struct UniformType<int> {
+  static constexpr GLenum value = GL_INT;
+};
+template <> struct UniformType<float> {
+  static constexpr GLenum value = GL_FLOAT;
+};
+template <> struct UniformType<glm::vec2> {
+  static constexpr GLenum value = GL_FLOAT_VEC2;
+};
+template <> struct UniformType<glm::vec3> {
+  static constexpr GLenum value = GL_FLOAT_VEC3;
+};
+template <> struct UniformType<glm::vec4> {
+  static constexpr GLenum value = GL_FLOAT_VEC4;
+};
+template <> struct UniformType<glm::mat3> {
+  static constexpr GLenum value = GL_FLOAT_MAT3;
+};
+template <> struct UniformType<glm::mat4> {
+  static constexpr GLenum value = GL_FLOAT_MAT4;
+};
+
+// Typed uniform name whose hash is computed at compile time:
+//
+//   const Uniform<glm::mat4> MODEL{"model"};
+//   shader.set(MODEL, model);
+//
+// The handle is resolved against the shader's table on first use. Handles
+// for the last few programs are cached side by side, so one Uniform can be
+// shared between programs drawn in the same frame without resolving again.
+template <typename T> class Uniform {
+public:
+  static constexpr GLenum glType = UniformType<T>::value;
+
+  consteval explicit Uniform(std::string_view name)
+      : mName(name), mHash(hashUniformName(name)) {}
+
+  constexpr std::string_view name() const { return mName; }
+  constexpr uint64_t hash() const { return mHash; }
+
+private:
+  friend class Shader;
+
+  // handle per table serial, the oldest entry is replaced first
+  struct Cached {
+    uint64_t tableSerial{0};
+    UniformHandle handle{INVALID_UNIFORM};
+  };
+  static constexpr size_t CACHED_PROGRAMS = 4;
+
+  std::string_view mName;
+  uint64_t mHash;
+  mutable std::array<Cached, CACHED_PROGRAMS> mCached{};
+  mutable size_t mNextSlot{0};
+};
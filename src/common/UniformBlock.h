@@ -0,0 +1,55 @@
+#pragma once
+#include "common.h"
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <string>
+
+// Uniform buffer holding one struct in std140 layout, e.g. the transforms
+// of a batch of objects indexed by gl_InstanceID:
+//
+//   struct Objects { glm::mat4 model[16]; };
+//   layout (std140) uniform Objects { mat4 model[16]; };
+//
+// T has to follow std140 itself: vec3 members padded to 16 bytes, array
+// elements 16-byte aligned. Shader::bindUniformBlock connects programs to
+// the binding point, see attach().
+template <typename T> class UniformBlock {
+public:
+  UniformBlock(std::string name, GLuint bindingPoint)
+      : mName{std::move(name)}, mBindingPoint{bindingPoint} {
+    glGenBuffers(1, &mUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, mBindingPoint, mUbo);
+  }
+  UniformBlock(const UniformBlock &) = delete;
+  UniformBlock &operator=(const UniformBlock &) = delete;
+  ~UniformBlock() {
+    if (glfwGetCurrentContext())
+      glDeleteBuffers(1, &mUbo);
+  }
+
+  const std::string &name() const { return mName; }
+  GLuint bindingPoint() const { return mBindingPoint; }
+
+  // bind the shader's block of the same name to this buffer
+  template <typename S> bool attach(S &shader) const {
+    return shader.bindUniformBlock(mName, mBindingPoint);
+  }
+
+  // the whole struct in one call
+  void update(const T &data) { update(data, sizeof(T)); }
+  // only the first `bytes`, e.g. the used part of an array
+  void update(const T &data, size_t bytes) {
+    glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                    &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+private:
+  std::string mName;
+  GLuint mBindingPoint;
+  unsigned int mUbo{0};
+};
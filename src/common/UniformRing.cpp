@@ -0,0 +1,116 @@
+#include "UniformRing.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <GLFW/glfw3.h>
+
+UniformRing::UniformRing(size_t blockBytes, size_t blocksPerFrame,
+                         unsigned int frames)
+    : mFrames(frames), mFences(frames, nullptr) {
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment > 0)
+    mAlignment = static_cast<size_t>(alignment);
+  // every block starts on an aligned offset
+  mFrameBytes = align(blockBytes) * blocksPerFrame;
+  auto size = static_cast<GLsizeiptr>(mFrameBytes * mFrames);
+
+  glext::load();
+  glGenBuffers(1, &mUbo);
+  glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+  if (glext::hasBufferStorage()) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glext::glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    mMapped = static_cast<unsigned char *>(
+        glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+  }
+  if (!mMapped) {
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    mStaging.resize(mFrameBytes);
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRing::~UniformRing() {
+  // fences and buffer went with the context if the window is already gone
+  if (!glfwGetCurrentContext())
+    return;
+  for (auto fence : mFences)
+    if (fence)
+      glDeleteSync(fence);
+  if (mMapped) {
+    glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  glDeleteBuffers(1, &mUbo);
+}
+
+void UniformRing::beginFrame() {
+  mFrame = (mFrame + 1) % mFrames;
+  mHead = 0;
+  mUploaded = 0;
+
+  auto &fence = mFences[mFrame];
+  if (!fence)
+    return;
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+    ++mStats.waits;
+    // flush once so the fence is guaranteed to signal
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+      flags = 0;
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+UniformRing::Range UniformRing::allocate(const void *data, size_t bytes) {
+  if (mHead + bytes > mFrameBytes) {
+    std::cout << "ERROR::UNIFORM_RING::FULL a frame needs more than "
+              << mFrameBytes << " bytes" << std::endl;
+    return {};
+  }
+
+  auto offset = mHead;
+  if (mMapped)
+    std::memcpy(mMapped + frame_base() + offset, data, bytes);
+  else
+    std::memcpy(mStaging.data() + offset, data, bytes);
+  mHead = std::min(align(offset + bytes), mFrameBytes);
+  mStats.bytes += bytes;
+  return {static_cast<GLintptr>(frame_base() + offset),
+          static_cast<GLsizeiptr>(bytes)};
+}
+
+void UniformRing::upload() {
+  if (mMapped || mHead == mUploaded)
+    return;
+  // the fence in beginFrame() made sure the GPU is done with this slice,
+  // so the driver needn't synchronize
+  auto bytes = mHead - mUploaded;
+  glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+  auto *target = glMapBufferRange(
+      GL_UNIFORM_BUFFER, static_cast<GLintptr>(frame_base() + mUploaded),
+      static_cast<GLsizeiptr>(bytes),
+      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+          GL_MAP_INVALIDATE_RANGE_BIT);
+  if (target) {
+    std::memcpy(target, mStaging.data() + mUploaded, bytes);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  mUploaded = mHead;
+}
+
+void UniformRing::bind(const Range &range, GLuint bindingPoint) const {
+  if (range.valid())
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, mUbo, range.offset,
+                      range.size);
+}
+
+void UniformRing::endFrame() {
+  mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
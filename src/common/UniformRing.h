@@ -0,0 +1,78 @@
+#pragma once
+#include "common.h"
+#include <cstddef>
+#include <vector>
+
+// Ring of uniform buffer memory for per-draw constants. Each frame gets its
+// own slice; a draw's block is written with allocate() and bound with
+// bind(), i.e. glBindBufferRange at its offset, instead of going through
+// glUniform* calls. A fence per slice keeps frames still being rendered
+// from being overwritten.
+//
+//   ring.beginFrame();
+//   auto range = ring.allocate(DrawUniformsData{model, color});
+//   ring.upload(); // once all draws are allocated
+//   ring.bind(range, DrawUniforms::BINDING_POINT); // per draw
+//   ...draw...
+//   ring.endFrame();
+//
+// With GL 4.4 / ARB_buffer_storage the buffer is mapped persistently and
+// allocate() writes straight into it; otherwise allocations are staged and
+// upload() copies them with one unsynchronized map per frame.
+class UniformRing {
+public:
+  struct Range {
+    GLintptr offset{0};
+    GLsizeiptr size{0};
+    bool valid() const { return size > 0; }
+  };
+
+  // room for `blocksPerFrame` blocks of up to `blockBytes` each per frame,
+  // `frames` frames in flight
+  UniformRing(size_t blockBytes, size_t blocksPerFrame,
+              unsigned int frames = 3);
+  UniformRing(const UniformRing &) = delete;
+  UniformRing &operator=(const UniformRing &) = delete;
+  ~UniformRing();
+
+  // waits for the GPU only if it is still reading this frame's slice
+  void beginFrame();
+  template <typename T> Range allocate(const T &data) {
+    return allocate(&data, sizeof(T));
+  }
+  // an invalid range when the frame's slice is full
+  Range allocate(const void *data, size_t bytes);
+  // make the allocations so far visible to the GPU
+  void upload();
+  void bind(const Range &range, GLuint bindingPoint) const;
+  void endFrame();
+
+  bool persistent() const { return mMapped != nullptr; }
+
+  struct Stats {
+    // times beginFrame() had to block on a fence
+    unsigned int waits{0};
+    size_t bytes{0};
+  };
+  Stats getStats() const { return mStats; }
+  void resetStats() { mStats = {}; }
+
+private:
+  size_t frame_base() const { return mFrame * mFrameBytes; }
+  size_t align(size_t bytes) const {
+    return (bytes + mAlignment - 1) / mAlignment * mAlignment;
+  }
+
+  unsigned int mUbo{0};
+  size_t mFrameBytes{0};
+  unsigned int mFrames;
+  unsigned int mFrame{0};
+  size_t mAlignment{256};
+  // write position in the current slice, and how much of it is uploaded
+  size_t mHead{0};
+  size_t mUploaded{0};
+  unsigned char *mMapped{nullptr};
+  std::vector<unsigned char> mStaging;
+  std::vector<GLsync> mFences;
+  Stats mStats;
+};
@@ -0,0 +1,177 @@
+#include "UniformTable.h"
+#include <algorithm>
+
+size_t UniformTable::load(GLuint program, const UniformTable *keep) {
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::string buffer(static_cast<size_t>(maxLength), '\0');
+
+  std::vector<UniformInfo> active;
+  size_t shadowSize = 0;
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    UniformInfo info;
+    glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length,
+                       &info.size, &info.type, buffer.data());
+    info.name.assign(buffer.data(), static_cast<size_t>(length));
+    // members of uniform blocks have no location
+    info.location = glGetUniformLocation(program, info.name.c_str());
+    if (info.location < 0)
+      continue;
+
+    info.shadowOffset = shadowSize;
+    info.shadowBytes =
+        uniformTypeSize(info.type) * static_cast<size_t>(info.size);
+    shadowSize += info.shadowBytes;
+
+    // arrays are reported as "name[0]", make the bare name resolve as well;
+    // both names share one shadow copy
+    if (info.name.ends_with("[0]")) {
+      UniformInfo bare = info;
+      bare.name.resize(bare.name.size() - 3);
+      active.push_back(std::move(bare));
+    }
+    active.push_back(std::move(info));
+  }
+
+  clear();
+  std::vector<bool> added(active.size(), false);
+  if (keep) {
+    // same names at the same handles; names that are no longer active (or
+    // were looked up by hand, like "lights[2]") are resolved again but lose
+    // their shadow copy
+    for (auto &previous : keep->mEntries) {
+      auto it = std::find_if(active.begin(), active.end(), [&](auto &info) {
+        return info.name == previous.name;
+      });
+      if (it != active.end()) {
+        added[static_cast<size_t>(it - active.begin())] = true;
+        add(*it);
+        continue;
+      }
+      UniformInfo info;
+      info.name = previous.name;
+      info.location = glGetUniformLocation(program, info.name.c_str());
+      add(std::move(info));
+    }
+  }
+  for (size_t i = 0; i < active.size(); ++i)
+    if (!added[i])
+      add(std::move(active[i]));
+  return shadowSize;
+}
+
+void UniformTable::clear() {
+  mEntries.clear();
+  mHashes.clear();
+  mSlots.clear();
+}
+
+UniformHandle UniformTable::add(UniformInfo info) {
+  // keep the load factor below 1/2 so probe sequences stay short
+  if ((mEntries.size() + 1) * 2 > mSlots.size())
+    rehash(mSlots.empty() ? 16 : mSlots.size() * 2);
+
+  auto hash = hashUniformName(info.name);
+  auto handle = static_cast<UniformHandle>(mEntries.size());
+  mEntries.push_back(std::move(info));
+  mHashes.push_back(hash);
+  insert_slot(hash, handle);
+  return handle;
+}
+
+UniformHandle UniformTable::find(uint64_t hash, std::string_view name) const {
+  if (mSlots.empty())
+    return INVALID_UNIFORM;
+
+  size_t mask = mSlots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    auto handle = mSlots[i];
+    if (handle == INVALID_UNIFORM)
+      return INVALID_UNIFORM;
+    auto index = static_cast<size_t>(handle);
+    if (mHashes[index] == hash && mEntries[index].name == name)
+      return handle;
+  }
+}
+
+void UniformTable::rehash(size_t capacity) {
+  mSlots.assign(capacity, INVALID_UNIFORM);
+  for (size_t i = 0; i < mEntries.size(); ++i)
+    insert_slot(mHashes[i], static_cast<UniformHandle>(i));
+}
+
+void UniformTable::insert_slot(uint64_t hash, UniformHandle handle) {
+  size_t mask = mSlots.size() - 1;
+  size_t i = hash & mask;
+  while (mSlots[i] != INVALID_UNIFORM)
+    i = (i + 1) & mask;
+  mSlots[i] = handle;
+}
+
+size_t uniformTypeSize(GLenum type) {
+  switch (type) {
+  case GL_FLOAT:
+  case GL_INT:
+  case GL_UNSIGNED_INT:
+  case GL_BOOL:
+  case GL_SAMPLER_1D:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_CUBE:
+  case GL_SAMPLER_2D_SHADOW:
+  case GL_SAMPLER_2D_ARRAY:
+    return 4;
+  case GL_FLOAT_VEC2:
+  case GL_INT_VEC2:
+  case GL_UNSIGNED_INT_VEC2:
+  case GL_BOOL_VEC2:
+    return 8;
+  case GL_FLOAT_VEC3:
+  case GL_INT_VEC3:
+  case GL_UNSIGNED_INT_VEC3:
+  case GL_BOOL_VEC3:
+    return 12;
+  case GL_FLOAT_VEC4:
+  case GL_INT_VEC4:
+  case GL_UNSIGNED_INT_VEC4:
+  case GL_BOOL_VEC4:
+  case GL_FLOAT_MAT2:
+    return 16;
+  case GL_FLOAT_MAT2x3:
+  case GL_FLOAT_MAT3x2:
+    return 24;
+  case GL_FLOAT_MAT2x4:
+  case GL_FLOAT_MAT4x2:
+    return 32;
+  case GL_FLOAT_MAT3:
+    return 36;
+  case GL_FLOAT_MAT3x4:
+  case GL_FLOAT_MAT4x3:
+    return 48;
+  case GL_FLOAT_MAT4:
+    return 64;
+  default:
+    return 0;
+  }
+}
+
+bool uniformTypeCompatible(GLenum expected, GLenum actual) {
+  if (expected == actual)
+    return true;
+  if (expected != GL_INT)
+    return false;
+  switch (actual) {
+  case GL_BOOL:
+  case GL_SAMPLER_1D:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_CUBE:
+  case GL_SAMPLER_2D_SHADOW:
+  case GL_SAMPLER_2D_ARRAY:
+    return true;
+  default:
+    return false;
+  }
+}
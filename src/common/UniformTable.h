@@ -0,0 +1,70 @@
+#pragma once
+#include "common.h"
+#include "Hash.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Index of an entry in a UniformTable. Stays valid for the lifetime of the
+// program it was resolved from.
+using UniformHandle = int;
+constexpr UniformHandle INVALID_UNIFORM = -1;
+
+constexpr uint64_t hashUniformName(std::string_view name) {
+  return fnv1a(name);
+}
+
+struct UniformInfo {
+  std::string name;
+  GLint location{-1};
+  GLenum type{0};
+  // array length, 1 for non-array uniforms
+  GLint size{0};
+  // slice of the owner's copy of the last uploaded value, 0 bytes when the
+  // uniform isn't shadowed
+  size_t shadowOffset{0};
+  size_t shadowBytes{0};
+};
+
+// bytes of client data glUniform* reads per element of the given type,
+// 0 for types not known here
+size_t uniformTypeSize(GLenum type);
+// whether a value for GL type `expected` may be written to a uniform
+// declared as `actual`; ints also cover bools and samplers
+bool uniformTypeCompatible(GLenum expected, GLenum actual);
+
+// Open addressing hash table of the active uniforms of a linked program.
+// Entries are only ever appended, so a handle returned once keeps pointing
+// at the same uniform.
+class UniformTable {
+public:
+  // replace the contents with the active uniforms of a linked program and
+  // return the bytes needed to shadow all their values. Passing the table of
+  // an earlier build of the same shader keeps its handles valid.
+  size_t load(GLuint program, const UniformTable *keep = nullptr);
+  void clear();
+  UniformHandle add(UniformInfo info);
+
+  UniformHandle find(std::string_view name) const {
+    return find(hashUniformName(name), name);
+  }
+  UniformHandle find(uint64_t hash, std::string_view name) const;
+
+  const UniformInfo &operator[](UniformHandle handle) const {
+    return mEntries[static_cast<size_t>(handle)];
+  }
+  bool valid(UniformHandle handle) const {
+    return handle >= 0 && static_cast<size_t>(handle) < mEntries.size();
+  }
+  size_t size() const { return mEntries.size(); }
+
+private:
+  void rehash(size_t capacity);
+  void insert_slot(uint64_t hash, UniformHandle handle);
+
+  std::vector<UniformInfo> mEntries;
+  std::vector<uint64_t> mHashes;
+  // power of two sized, INVALID_UNIFORM marks an empty slot
+  std::vector<UniformHandle> mSlots;
+};
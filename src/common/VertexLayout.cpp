@@ -0,0 +1,75 @@
+#include "VertexLayout.h"
+
+VertexLayout vertexLayoutOf(unsigned int vao) {
+  GLint previous = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+  glBindVertexArray(vao);
+
+  VertexLayout layout;
+  GLint maxAttributes = 0;
+  glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+  for (GLuint i = 0; i < static_cast<GLuint>(maxAttributes); ++i) {
+    GLint enabled = 0;
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+    if (!enabled)
+      continue;
+
+    GLint components, type, stride, integer;
+    void *offset = nullptr;
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &components);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+    glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &integer);
+    glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &offset);
+    layout.push_back({i, components, static_cast<GLenum>(type), stride,
+                      reinterpret_cast<size_t>(offset), integer != 0});
+  }
+
+  glBindVertexArray(static_cast<GLuint>(previous));
+  return layout;
+}
+
+AttributeShape attributeShape(GLenum type) {
+  switch (type) {
+  case GL_FLOAT:
+    return {1, 1, false};
+  case GL_FLOAT_VEC2:
+    return {2, 1, false};
+  case GL_FLOAT_VEC3:
+    return {3, 1, false};
+  case GL_FLOAT_VEC4:
+    return {4, 1, false};
+  case GL_INT:
+  case GL_UNSIGNED_INT:
+    return {1, 1, true};
+  case GL_INT_VEC2:
+  case GL_UNSIGNED_INT_VEC2:
+    return {2, 1, true};
+  case GL_INT_VEC3:
+  case GL_UNSIGNED_INT_VEC3:
+    return {3, 1, true};
+  case GL_INT_VEC4:
+  case GL_UNSIGNED_INT_VEC4:
+    return {4, 1, true};
+  case GL_FLOAT_MAT2:
+    return {2, 2, false};
+  case GL_FLOAT_MAT3:
+    return {3, 3, false};
+  case GL_FLOAT_MAT4:
+    return {4, 4, false};
+  case GL_FLOAT_MAT2x3:
+    return {3, 2, false};
+  case GL_FLOAT_MAT2x4:
+    return {4, 2, false};
+  case GL_FLOAT_MAT3x2:
+    return {2, 3, false};
+  case GL_FLOAT_MAT3x4:
+    return {4, 3, false};
+  case GL_FLOAT_MAT4x2:
+    return {2, 4, false};
+  case GL_FLOAT_MAT4x3:
+    return {3, 4, false};
+  default:
+    return {};
+  }
+}
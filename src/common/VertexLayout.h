@@ -0,0 +1,29 @@
+#pragma once
+#include "common.h"
+#include <cstddef>
+#include <vector>
+
+// One glVertexAttribPointer (or glVertexAttribIPointer) call
+struct VertexAttribute {
+  GLuint location;
+  GLint components;
+  GLenum type{GL_FLOAT};
+  GLsizei stride{0};
+  size_t offset{0};
+  // set up with glVertexAttribIPointer, required for int shader inputs
+  bool integer{false};
+};
+
+using VertexLayout = std::vector<VertexAttribute>;
+
+// reads back the enabled attributes of a vertex array object
+VertexLayout vertexLayoutOf(unsigned int vao);
+
+// component count and column count of a GLSL attribute type as reported by
+// glGetActiveAttrib, e.g. vec3 -> 3x1, mat4 -> 4x4
+struct AttributeShape {
+  GLint components{0};
+  GLint columns{0};
+  bool integer{false};
+};
+AttributeShape attributeShape(GLenum type);
@@ -1,112 +1,755 @@
 #include "shader.h"
+#include "DrawUniforms.h"
+#include "FrameUniforms.h"
+#include "GLExtensions.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderWatcher.h"
 #include <GLFW/glfw3.h>
-#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <sstream>
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath) {
-  std::string vertexCode;
-  std::string fragmentCode;
+std::string shaderInfoLog(unsigned int shader) {
+  GLint length = 0;
+  glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+  std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+  glGetShaderInfoLog(shader, length, nullptr, log.data());
+  log.resize(static_cast<size_t>(std::max(length - 1, 0)));
+  return log;
+}
+
+std::string programInfoLog(unsigned int program) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+  std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+  glGetProgramInfoLog(program, length, nullptr, log.data());
+  log.resize(static_cast<size_t>(std::max(length - 1, 0)));
+  return log;
+}
+
+namespace {
+bool bind_storage_block(GLuint program, const std::string &name,
+                        GLuint bindingPoint) {
+  if (!glext::hasShaderStorageBuffers())
+    return false;
+  auto block = glext::glGetProgramResourceIndex(
+      program, GL_SHADER_STORAGE_BLOCK, name.c_str());
+  if (block == GL_INVALID_INDEX)
+    return false;
+  glext::glShaderStorageBlockBinding(program, block, bindingPoint);
+  return true;
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+double &compile_time(Shader::BuildStats &stats, GLenum shaderType) {
+  return shaderType == GL_VERTEX_SHADER ? stats.vertexCompileMs
+                                        : stats.fragmentCompileMs;
+}
 
-  read_shader_file(vertexPath, fragmentPath, &vertexCode, &fragmentCode);
-  const char *vShaderCode = vertexCode.c_str();
-  const char *fShaderCode = fragmentCode.c_str();
+// shaders built through the public constructors, for printBuildReport()
+std::vector<const Shader *> &live_shaders() {
+  static std::vector<const Shader *> shaders;
+  return shaders;
+}
+} // namespace
 
-  auto vertexShader = compile_shader(GL_VERTEX_SHADER, vShaderCode, "vertex");
-  auto fragmentShader =
-      compile_shader(GL_FRAGMENT_SHADER, fShaderCode, "fragement");
+Shader::Shader(const char *vertexPath, const char *fragmentPath,
+               const ShaderDefines &defines) {
+  mSources.vertexPath = vertexPath;
+  mSources.fragmentPath = fragmentPath;
+  mSources.defines = defines;
 
-  mId = create_program(vertexShader, fragmentShader);
+  PreprocessedSource vertexCode;
+  PreprocessedSource fragmentCode;
+  mBuildStart = std::chrono::steady_clock::now();
+  mSources.read(&vertexCode, &fragmentCode);
+  mBuildStats.readMs = ms_since(mBuildStart);
+  build(vertexCode, fragmentCode);
+  track(vertexCode, fragmentCode);
 }
 
-void Shader::read_shader_file(const char *vertexPath, const char *fragmentPath,
-                              std::string *vertexCode, std::string *fragCode) {
-  try {
-    std::ifstream vShaderFile{vertexPath};
-    std::ifstream fShaderFile{fragmentPath};
+Shader::Shader(const EmbeddedFile &vertex, const EmbeddedFile &fragment,
+               const ShaderDefines &defines) {
+  mSources.vertexPath = vertex.path;
+  mSources.fragmentPath = fragment.path;
+  mSources.vertexText = vertex.source;
+  mSources.fragmentText = fragment.source;
+  mSources.embedded = true;
+  mSources.defines = defines;
+
+  PreprocessedSource vertexCode;
+  PreprocessedSource fragmentCode;
+  mBuildStart = std::chrono::steady_clock::now();
+  mSources.read(&vertexCode, &fragmentCode);
+  mBuildStats.readMs = ms_since(mBuildStart);
+  build(vertexCode, fragmentCode);
+  track(vertexCode, fragmentCode);
+}
+
+Shader::Shader(PreprocessedSource const &vertexCode,
+               PreprocessedSource const &fragmentCode)
+    : mBuildStart{std::chrono::steady_clock::now()} {
+  build(vertexCode, fragmentCode);
+}
 
-    std::stringstream vShaderStream, fShaderStream;
-    // read file’s buffer contents into streams
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
-    // close file handlers
-    vShaderFile.close();
-    fShaderFile.close();
-    // convert stream into string
-    *vertexCode = vShaderStream.str();
-    *fragCode = fShaderStream.str();
-  } catch (std::ifstream::failure &e) {
-    std::cout << "ERROR: SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+void Shader::build(PreprocessedSource const &vertexCode,
+                   PreprocessedSource const &fragmentCode) {
+  if (!vertexCode.ok || !fragmentCode.ok) {
+    // nothing to compile; isReady() stays false and use() binds program 0
+    mId = 0;
+    mState = State::Failed;
+    return;
   }
+
+  // a cached binary from an earlier launch skips compile and link entirely
+  mBinaryKey =
+      ProgramBinaryCache::key({vertexCode.segments, fragmentCode.segments});
+  mId = ProgramBinaryCache::load(mBinaryKey);
+  if (mId != 0) {
+    load_uniforms(mId);
+    load_attributes(mId);
+    mState = State::Linked;
+    mBuildStats.fromBinaryCache = true;
+    record_link_time();
+    collect_stats();
+    return;
+  }
+
+  // only submit the work here; status is queried in finish_link() so the
+  // driver can compile several programs in parallel
+  mVertexShader = compile_shader(GL_VERTEX_SHADER, vertexCode, "vertex");
+  mFragmentShader =
+      compile_shader(GL_FRAGMENT_SHADER, fragmentCode, "fragement");
+
+  mId = create_program(mVertexShader, mFragmentShader);
 }
 
-unsigned int Shader::compile_shader(GLenum shaderType, const char *shaderCode,
+void Shader::track(PreprocessedSource const &vertexCode,
+                   PreprocessedSource const &fragmentCode) {
+  auto files = vertexCode.files;
+  files.insert(files.end(), fragmentCode.files.begin(),
+               fragmentCode.files.end());
+  ShaderWatcher::add(this, mSources, std::move(files));
+  live_shaders().push_back(this);
+}
+
+unsigned int Shader::compile_shader(GLenum shaderType,
+                                    PreprocessedSource const &shaderCode,
                                     std::string const &shader_name) {
-  int success;
-  char infoLog[512];
-  // vertex Shader
+  // hand the segments over as they are; the mapped file contents are copied
+  // exactly once, by the driver
+  std::vector<const GLchar *> strings;
+  std::vector<GLint> lengths;
+  for (auto segment : shaderCode.segments) {
+    strings.push_back(segment.data());
+    lengths.push_back(static_cast<GLint>(segment.size()));
+  }
+
+  auto start = std::chrono::steady_clock::now();
   auto shader = glCreateShader(shaderType);
-  glShaderSource(shader, 1, &shaderCode, NULL);
+  glShaderSource(shader, static_cast<GLsizei>(strings.size()), strings.data(),
+                 lengths.data());
   glCompileShader(shader);
-  // print compile errors if any
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(shader, 512, NULL, infoLog);
-    std::cout << "ERROR Failed to compile SHADER('" << shader_name << "',"
-              << shaderType << ")\n"
-              << infoLog << std::endl;
-  };
+  compile_time(mBuildStats, shaderType) += ms_since(start);
+  mShaderNames.emplace_back(shader, shader_name);
   return shader;
 }
 
 unsigned int Shader::create_program(unsigned int vertex,
                                     unsigned int fragment) {
-  int success;
-  char infoLog[512];
+  glext::load();
+  if (glext::glMaxShaderCompilerThreadsKHR) {
+    static bool threadsRequested = false;
+    if (!threadsRequested) {
+      // let the driver pick as many compiler threads as it likes
+      glext::glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+      threadsRequested = true;
+    }
+  }
+
   unsigned int id = glCreateProgram();
   glAttachShader(id, vertex);
   glAttachShader(id, fragment);
+  ProgramBinaryCache::prepare(id);
+  auto start = std::chrono::steady_clock::now();
   glLinkProgram(id);
+  mBuildStats.linkMs += ms_since(start);
+  return id;
+}
+
+bool Shader::isReady() const {
+  return link_finished() && mState == State::Linked;
+}
+
+bool Shader::link_finished() const {
+  if (mState == State::Pending && glext::glMaxShaderCompilerThreadsKHR) {
+    int done;
+    glGetProgramiv(mId, GL_COMPLETION_STATUS_KHR, &done);
+    if (!done)
+      return false;
+    // now rather than in finish_link(), which may only run at first use
+    record_link_time();
+  }
+  // without the extension this blocks until the link is done
+  finish_link();
+  return true;
+}
+
+void Shader::finish_link() const {
+  if (mState != State::Pending)
+    return;
+
+  int success;
+  // print compile errors if any
+  for (auto &[shader, shader_name] : mShaderNames) {
+    GLint shaderType;
+    glGetShaderiv(shader, GL_SHADER_TYPE, &shaderType);
+    // the status query waits for the compile if it is still running
+    auto start = std::chrono::steady_clock::now();
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    compile_time(mBuildStats, static_cast<GLenum>(shaderType)) +=
+        ms_since(start);
+    if (!success)
+      std::cout << "ERROR Failed to compile SHADER('" << shader_name << "',"
+                << shaderType << ")\n"
+                << shaderInfoLog(shader) << std::endl;
+  }
   // print linking errors if any
-  glGetProgramiv(id, GL_LINK_STATUS, &success);
+  auto start = std::chrono::steady_clock::now();
+  glGetProgramiv(mId, GL_LINK_STATUS, &success);
+  mBuildStats.linkMs += ms_since(start);
+  record_link_time();
   if (!success) {
-    glGetProgramInfoLog(id, 512, NULL, infoLog);
     std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-              << infoLog << std::endl;
+              << programInfoLog(mId) << std::endl;
+    mState = State::Failed;
+  } else {
+    load_uniforms(mId);
+    load_attributes(mId);
+    ProgramBinaryCache::store(mBinaryKey, mId);
+    mState = State::Linked;
+    collect_stats();
   }
   // delete shaders; they’re linked into our program and no longer necessary
-  glDeleteShader(vertex);
-  glDeleteShader(fragment);
-  return id;
+  glDeleteShader(mVertexShader);
+  glDeleteShader(mFragmentShader);
+  mShaderNames.clear();
+}
+
+namespace {
+// program last bound through Shader; assumes a single GL context and no
+// direct glUseProgram calls, see Shader::unbind()
+unsigned int current_program = 0;
+Shader::BindStats bind_stats;
+} // namespace
+
+void Shader::use() {
+  finish_link();
+  if (current_program == mId) {
+    ++bind_stats.elided;
+    return;
+  }
+  glUseProgram(mId);
+  current_program = mId;
+  ++bind_stats.issued;
+}
+
+void Shader::disable() {
+  // a real unbind, callers may bind programs or pipelines by hand next
+  if (current_program == mId)
+    unbind();
 }
 
-void Shader::use() { glUseProgram(mId); }
+void Shader::unbind() {
+  if (current_program != 0) {
+    glUseProgram(0);
+    ++bind_stats.issued;
+  }
+  current_program = 0;
+}
 
-void Shader::disable() { glUseProgram(0); }
+Shader::BindStats Shader::getBindStats() { return bind_stats; }
+
+void Shader::resetBindStats() { bind_stats = {}; }
+
+void Shader::load_uniforms(unsigned int program,
+                           const UniformTable *keep) const {
+  auto shadowSize = mUniforms.load(program, keep);
+  mShadow.assign(shadowSize, 0);
+  mShadowWritten.assign(mUniforms.size(), false);
+  static uint64_t tableSerial = 0;
+  mTableSerial = ++tableSerial;
+
+  FrameUniforms::attach(program);
+  DrawUniforms::attach(program);
+  for (auto &[name, bindingPoint] : mBlockBindings) {
+    auto block = glGetUniformBlockIndex(program, name.c_str());
+    if (block != GL_INVALID_INDEX)
+      glUniformBlockBinding(program, block, bindingPoint);
+  }
+  for (auto &[name, bindingPoint] : mStorageBindings)
+    bind_storage_block(program, name, bindingPoint);
+}
+
+void Shader::load_attributes(unsigned int program) const {
+  mAttributes.clear();
+
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+  std::string buffer(static_cast<size_t>(maxLength), '\0');
+
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    AttributeInfo info;
+    glGetActiveAttrib(program, static_cast<GLuint>(i), maxLength, &length,
+                      &info.size, &info.type, buffer.data());
+    info.name.assign(buffer.data(), static_cast<size_t>(length));
+    info.location = glGetAttribLocation(program, info.name.c_str());
+    mAttributes.push_back(std::move(info));
+  }
+}
+
+const std::vector<Shader::AttributeInfo> &Shader::getActiveAttributes() const {
+  finish_link();
+  return mAttributes;
+}
+
+bool Shader::validateLayout(const VertexLayout &layout) const {
+  auto find = [&](GLuint location) -> const VertexAttribute * {
+    for (auto &attribute : layout)
+      if (attribute.location == location)
+        return &attribute;
+    return nullptr;
+  };
+
+  bool valid = true;
+  for (auto &input : getActiveAttributes()) {
+    if (input.location < 0)
+      continue;
+
+    // matrices and arrays take one location per column / element
+    auto shape = attributeShape(input.type);
+    auto slots = shape.columns * input.size;
+    for (GLint slot = 0; slot < slots; ++slot) {
+      auto location = static_cast<GLuint>(input.location + slot);
+      auto *attribute = find(location);
+      if (!attribute) {
+        std::cout << "ERROR::SHADER::LAYOUT input '" << input.name
+                  << "' (location " << location
+                  << ") is not fed by any vertex attribute" << std::endl;
+        valid = false;
+        continue;
+      }
+      // a vec4 fed with 3 components gets w = 1, which is how positions
+      // are commonly passed; everything else must match exactly
+      bool implicitW = shape.components == 4 && attribute->components == 3;
+      if (attribute->components != shape.components && !implicitW) {
+        std::cout << "ERROR::SHADER::LAYOUT input '" << input.name
+                  << "' (location " << location << ") expects "
+                  << shape.components << " components, the buffer provides "
+                  << attribute->components << std::endl;
+        valid = false;
+      }
+      if (attribute->integer != shape.integer) {
+        std::cout << "ERROR::SHADER::LAYOUT input '" << input.name
+                  << "' (location " << location << ") is "
+                  << (shape.integer ? "an integer" : "a float")
+                  << " input but set up with "
+                  << (attribute->integer ? "glVertexAttribIPointer"
+                                         : "glVertexAttribPointer")
+                  << std::endl;
+        valid = false;
+      }
+    }
+  }
+  return valid;
+}
+
+UniformHandle Shader::getUniformHandle(const std::string &name) const {
+  finish_link();
+  auto handle = mUniforms.find(name);
+  if (handle != INVALID_UNIFORM)
+    return handle;
+
+  // not an active uniform under this spelling; ask the driver once and cache
+  // the answer, including misses, so the next lookup stays in the table
+  UniformInfo info;
+  info.name = name;
+  info.location = glGetUniformLocation(mId, name.c_str());
+
+  // an element of an active array, e.g. "lights[2]", shadows into the
+  // array's storage so writes through either name stay consistent
+  auto bracket = name.rfind('[');
+  if (info.location >= 0 && bracket != std::string::npos &&
+      name.back() == ']') {
+    auto array = mUniforms.find(std::string_view{name}.substr(0, bracket));
+    auto index = std::strtoul(name.c_str() + bracket + 1, nullptr, 10);
+    if (array != INVALID_UNIFORM &&
+        index < static_cast<unsigned long>(mUniforms[array].size)) {
+      auto const &base = mUniforms[array];
+      auto elementSize = uniformTypeSize(base.type);
+      info.type = base.type;
+      info.size = base.size - static_cast<GLint>(index);
+      info.shadowOffset = base.shadowOffset + elementSize * index;
+      info.shadowBytes = elementSize * static_cast<size_t>(info.size);
+    }
+  }
+  mShadowWritten.push_back(false);
+  return mUniforms.add(std::move(info));
+}
+
+UniformHandle Shader::resolve(uint64_t hash, std::string_view name,
+                              GLenum type) const {
+  auto handle = mUniforms.find(hash, name);
+  if (handle == INVALID_UNIFORM)
+    handle = getUniformHandle(std::string{name});
+
+  auto const &info = mUniforms[handle];
+  // type 0 means the driver didn't report it, nothing to compare against
+  if (info.location >= 0 && info.type != 0 &&
+      !uniformTypeCompatible(type, info.type)) {
+    std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH '" << name
+              << "' is declared as GL type 0x" << std::hex << info.type
+              << " but set as 0x" << type << std::dec << std::endl;
+    return TYPE_MISMATCH;
+  }
+  return handle;
+}
+
+namespace {
+Shader::UploadStats upload_stats;
+} // namespace
+
+bool Shader::needs_upload(UniformHandle handle, GLenum type, const void *data,
+                          size_t bytes) const {
+  if (!mUniforms.valid(handle) || mUniforms[handle].location < 0)
+    return false;
+
+  // glUniform* writes to the bound program and fails on a type or size
+  // other than declared; the shadow only follows uploads that surely land
+  auto const &info = mUniforms[handle];
+  auto index = static_cast<size_t>(handle);
+  if (current_program != mId || bytes != info.shadowBytes ||
+      !uniformTypeCompatible(type, info.type)) {
+    mShadowWritten[index] = false;
+    ++upload_stats.issued;
+    return true;
+  }
+
+  auto *shadow = mShadow.data() + info.shadowOffset;
+  if (mShadowWritten[index] && std::memcmp(shadow, data, bytes) == 0) {
+    ++upload_stats.skipped;
+    return false;
+  }
+  std::memcpy(shadow, data, bytes);
+  mShadowWritten[index] = true;
+  ++upload_stats.issued;
+  return true;
+}
+
+Shader::UploadStats Shader::getUploadStats() { return upload_stats; }
+
+void Shader::resetUploadStats() { upload_stats = {}; }
+
+GLint Shader::location(UniformHandle handle) const {
+  return mUniforms.valid(handle) ? mUniforms[handle].location : -1;
+}
 
 void Shader::setBool(const std::string &name, bool value) const {
-  glUniform1i(glGetUniformLocation(mId, name.c_str()), (int)value);
+  setBool(getUniformHandle(name), value);
 }
 void Shader::setInt(const std::string &name, int value) const {
-  glUniform1i(glGetUniformLocation(mId, name.c_str()), value);
+  setInt(getUniformHandle(name), value);
 }
 void Shader::setFloat(const std::string &name, float value) const {
-  glUniform1f(glGetUniformLocation(mId, name.c_str()), value);
+  setFloat(getUniformHandle(name), value);
 }
 void Shader::setVec3(const std::string &name, float x, float y, float z) const {
-  glUniform3f(glGetUniformLocation(mId, name.c_str()), x, y, z);
+  setVec3(getUniformHandle(name), x, y, z);
 }
 
 void Shader::setVec3(const std::string &name, glm::vec3 const &vec3) const {
-  setVec3(name, vec3.x, vec3.y, vec3.z);
+  setVec3(getUniformHandle(name), vec3.x, vec3.y, vec3.z);
+}
+
+void Shader::setVec2(const std::string &name, glm::vec2 const &vec2) const {
+  setVec2(getUniformHandle(name), vec2);
+}
+
+void Shader::setVec4(const std::string &name, glm::vec4 const &vec4) const {
+  setVec4(getUniformHandle(name), vec4);
+}
+
+void Shader::setMat3f(const std::string &name, glm::mat3 const &mat) const {
+  setMat3f(getUniformHandle(name), mat);
 }
 
 void Shader::setMat4f(const std::string &name, glm::mat4 const &mat) const {
-  int var = glGetUniformLocation(mId, name.c_str());
-  glUniformMatrix4fv(var, 1, GL_FALSE, glm::value_ptr(mat));
+  setMat4f(getUniformHandle(name), mat);
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const {
+  setInt(handle, (int)value);
+}
+void Shader::setInt(UniformHandle handle, int value) const {
+  if (needs_upload(handle, GL_INT, &value, sizeof(value)))
+    glUniform1i(location(handle), value);
+}
+void Shader::setFloat(UniformHandle handle, float value) const {
+  if (needs_upload(handle, GL_FLOAT, &value, sizeof(value)))
+    glUniform1f(location(handle), value);
+}
+void Shader::setVec3(UniformHandle handle, float x, float y, float z) const {
+  float value[3]{x, y, z};
+  if (needs_upload(handle, GL_FLOAT_VEC3, value, sizeof(value)))
+    glUniform3f(location(handle), x, y, z);
+}
+
+void Shader::setVec3(UniformHandle handle, glm::vec3 const &vec3) const {
+  setVec3(handle, vec3.x, vec3.y, vec3.z);
+}
+
+void Shader::setVec2(UniformHandle handle, glm::vec2 const &vec2) const {
+  if (needs_upload(handle, GL_FLOAT_VEC2, glm::value_ptr(vec2),
+                   sizeof(float) * 2))
+    glUniform2fv(location(handle), 1, glm::value_ptr(vec2));
+}
+
+void Shader::setVec4(UniformHandle handle, glm::vec4 const &vec4) const {
+  if (needs_upload(handle, GL_FLOAT_VEC4, glm::value_ptr(vec4),
+                   sizeof(float) * 4))
+    glUniform4fv(location(handle), 1, glm::value_ptr(vec4));
+}
+
+void Shader::setMat3f(UniformHandle handle, glm::mat3 const &mat) const {
+  if (needs_upload(handle, GL_FLOAT_MAT3, glm::value_ptr(mat),
+                   sizeof(float) * 9))
+    glUniformMatrix3fv(location(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat4f(UniformHandle handle, glm::mat4 const &mat) const {
+  if (needs_upload(handle, GL_FLOAT_MAT4, glm::value_ptr(mat),
+                   sizeof(float) * 16))
+    glUniformMatrix4fv(location(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat4fArray(const std::string &name,
+                           std::span<const glm::mat4> values) const {
+  setMat4fArray(getUniformHandle(name), values);
+}
+
+void Shader::setVec3Array(const std::string &name,
+                          std::span<const glm::vec3> values) const {
+  setVec3Array(getUniformHandle(name), values);
+}
+
+void Shader::setMat4fArray(UniformHandle handle,
+                           std::span<const glm::mat4> values) const {
+  if (!values.empty() &&
+      needs_upload(handle, GL_FLOAT_MAT4, values.data(), values.size_bytes()))
+    glUniformMatrix4fv(location(handle), static_cast<GLsizei>(values.size()),
+                       GL_FALSE, glm::value_ptr(values[0]));
+}
+
+void Shader::setVec3Array(UniformHandle handle,
+                          std::span<const glm::vec3> values) const {
+  if (!values.empty() &&
+      needs_upload(handle, GL_FLOAT_VEC3, values.data(), values.size_bytes()))
+    glUniform3fv(location(handle), static_cast<GLsizei>(values.size()),
+                 glm::value_ptr(values[0]));
+}
+
+bool Shader::bindUniformBlock(const std::string &name, GLuint bindingPoint) {
+  finish_link();
+  std::erase_if(mBlockBindings,
+                [&](auto &binding) { return binding.first == name; });
+  mBlockBindings.emplace_back(name, bindingPoint);
+  if (mState != State::Linked)
+    return false;
+  auto block = glGetUniformBlockIndex(mId, name.c_str());
+  if (block == GL_INVALID_INDEX)
+    return false;
+  glUniformBlockBinding(mId, block, bindingPoint);
+  return true;
+}
+
+bool Shader::bindStorageBlock(const std::string &name, GLuint bindingPoint) {
+  finish_link();
+  std::erase_if(mStorageBindings,
+                [&](auto &binding) { return binding.first == name; });
+  mStorageBindings.emplace_back(name, bindingPoint);
+  return mState == State::Linked && bind_storage_block(mId, name, bindingPoint);
+}
+
+namespace {
+// write a uniform straight from its shadow copy, all array elements at once
+void upload_shadow(const UniformInfo &info, const unsigned char *data) {
+  auto count = static_cast<GLsizei>(info.size);
+  auto *f = reinterpret_cast<const GLfloat *>(data);
+  auto *i = reinterpret_cast<const GLint *>(data);
+  auto *u = reinterpret_cast<const GLuint *>(data);
+  switch (info.type) {
+  case GL_FLOAT:
+    return glUniform1fv(info.location, count, f);
+  case GL_FLOAT_VEC2:
+    return glUniform2fv(info.location, count, f);
+  case GL_FLOAT_VEC3:
+    return glUniform3fv(info.location, count, f);
+  case GL_FLOAT_VEC4:
+    return glUniform4fv(info.location, count, f);
+  case GL_INT:
+  case GL_BOOL:
+  case GL_SAMPLER_1D:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_CUBE:
+  case GL_SAMPLER_2D_SHADOW:
+  case GL_SAMPLER_2D_ARRAY:
+    return glUniform1iv(info.location, count, i);
+  case GL_INT_VEC2:
+  case GL_BOOL_VEC2:
+    return glUniform2iv(info.location, count, i);
+  case GL_INT_VEC3:
+  case GL_BOOL_VEC3:
+    return glUniform3iv(info.location, count, i);
+  case GL_INT_VEC4:
+  case GL_BOOL_VEC4:
+    return glUniform4iv(info.location, count, i);
+  case GL_UNSIGNED_INT:
+    return glUniform1uiv(info.location, count, u);
+  case GL_UNSIGNED_INT_VEC2:
+    return glUniform2uiv(info.location, count, u);
+  case GL_UNSIGNED_INT_VEC3:
+    return glUniform3uiv(info.location, count, u);
+  case GL_UNSIGNED_INT_VEC4:
+    return glUniform4uiv(info.location, count, u);
+  case GL_FLOAT_MAT2:
+    return glUniformMatrix2fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT3:
+    return glUniformMatrix3fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT4:
+    return glUniformMatrix4fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT2x3:
+    return glUniformMatrix2x3fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT3x2:
+    return glUniformMatrix3x2fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT2x4:
+    return glUniformMatrix2x4fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT4x2:
+    return glUniformMatrix4x2fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT3x4:
+    return glUniformMatrix3x4fv(info.location, count, GL_FALSE, f);
+  case GL_FLOAT_MAT4x3:
+    return glUniformMatrix4x3fv(info.location, count, GL_FALSE, f);
+  default:
+    return;
+  }
 }
+} // namespace
 
-Shader::~Shader() {}
+void Shader::adopt(Shader &next) {
+  auto previous = std::move(mUniforms);
+  auto previousShadow = std::move(mShadow);
+  auto previousWritten = std::move(mShadowWritten);
+
+  std::swap(mId, next.mId);
+  mState = State::Linked;
+  mBinaryKey = next.mBinaryKey;
+  mAttributes = std::move(next.mAttributes);
+  mBuildStats = next.mBuildStats;
+  // handles resolved so far keep naming the same uniforms
+  load_uniforms(mId, &previous);
+
+  // hand the last written values over so the swap doesn't show on screen;
+  // `next` now owns the old program and deletes it
+  if (current_program == next.mId)
+    unbind();
+  use();
+  for (size_t i = 0; i < previousWritten.size() && i < mUniforms.size(); ++i) {
+    auto handle = static_cast<UniformHandle>(i);
+    auto const &before = previous[handle];
+    auto const &after = mUniforms[handle];
+    if (!previousWritten[i] || after.location < 0 || after.shadowBytes == 0 ||
+        before.type != after.type || before.shadowBytes != after.shadowBytes)
+      continue;
+    auto *shadow = mShadow.data() + after.shadowOffset;
+    std::memcpy(shadow, previousShadow.data() + before.shadowOffset,
+                after.shadowBytes);
+    mShadowWritten[i] = true;
+    upload_shadow(after, shadow);
+  }
+}
+
+void Shader::record_link_time() const {
+  if (mLinkTimed)
+    return;
+  mBuildStats.totalMs = ms_since(mBuildStart);
+  mLinkTimed = true;
+}
+
+void Shader::collect_stats() const {
+  glGetProgramiv(mId, GL_ACTIVE_UNIFORMS, &mBuildStats.activeUniforms);
+  mBuildStats.activeAttributes = static_cast<GLint>(mAttributes.size());
+  if (glext::hasProgramBinary())
+    glGetProgramiv(mId, GL_PROGRAM_BINARY_LENGTH, &mBuildStats.binaryBytes);
+}
+
+const Shader::BuildStats &Shader::getBuildStats() const {
+  finish_link();
+  return mBuildStats;
+}
+
+void Shader::printBuildReport() {
+  auto shaders = live_shaders();
+  std::sort(shaders.begin(), shaders.end(), [](auto *a, auto *b) {
+    return a->getBuildStats().totalMs > b->getBuildStats().totalMs;
+  });
+
+  double total = 0;
+  std::cout << "SHADER::BUILD_REPORT (ms)\n";
+  for (auto *shader : shaders) {
+    auto &stats = shader->getBuildStats();
+    auto &sources = shader->mSources;
+    total += stats.totalMs;
+    std::cout << "  " << sources.vertexPath << " + " << sources.fragmentPath;
+    if (!sources.defines.empty())
+      std::cout << " [" << permutationKey(sources.defines) << ']';
+    std::cout << (shader->mState == State::Linked ? "" : " FAILED")
+              << "\n    total " << stats.totalMs << " read " << stats.readMs
+              << " vertex " << stats.vertexCompileMs << " fragment "
+              << stats.fragmentCompileMs << " link " << stats.linkMs
+              << (stats.fromBinaryCache ? " (binary cache)" : "")
+              << "\n    uniforms " << stats.activeUniforms << " attributes "
+              << stats.activeAttributes << " binary " << stats.binaryBytes
+              << " bytes\n";
+  }
+  std::cout << "  " << shaders.size() << " programs, " << total << " ms"
+            << std::endl;
+}
+
+Shader::~Shader() {
+  ShaderWatcher::remove(this);
+  std::erase(live_shaders(), this);
+
+  // the context may already be gone when a shader outlives glfwTerminate()
+  if (!glfwGetCurrentContext())
+    return;
+  // never finished linking
+  for (auto &[shader, shader_name] : mShaderNames)
+    glDeleteShader(shader);
+  if (mId == 0 || mId == std::numeric_limits<unsigned int>::max())
+    return;
+  if (current_program == mId)
+    unbind();
+  glDeleteProgram(mId);
+}
 
 unsigned int Shader::getProgramId() { return mId; }
@@ -1,35 +1,249 @@
 #pragma once
 #include "common.h"
+#include "ShaderPreprocessor.h"
+#include "Uniform.h"
+#include "UniformTable.h"
+#include "VertexLayout.h"
+#include <chrono>
 #include <numeric>
+#include <span>
 #include <string>
+#include <utility>
 #include <glm/matrix.hpp>
 #include <vector>
 
 class Shader {
 public:
-  // constructor reads and builds the shader
-  Shader(const char *vertexPath, const char *fragmentPath);
-  // use/activate the shader
+  // constructor reads and builds the shader, `defines` select a variant of
+  // the sources (see ShaderPreprocessor)
+  Shader(const char *vertexPath, const char *fragmentPath,
+         const ShaderDefines &defines = {});
+  // same for sources embedded at build time, #includes resolve against the
+  // other embedded files
+  Shader(const EmbeddedFile &vertex, const EmbeddedFile &fragment,
+         const ShaderDefines &defines = {});
+  // owns the GL program; share one through ShaderLibrary instead of copying
+  Shader(const Shader &) = delete;
+  Shader &operator=(const Shader &) = delete;
+  // Compile and link are only submitted by the constructor, so several
+  // shaders created back to back build in parallel on drivers with
+  // GL_KHR_parallel_shader_compile. isReady() polls without blocking there;
+  // use() and the uniform functions wait for the link when needed.
+  bool isReady() const;
+  // Sources on disk are rebuilt when they change while ShaderWatcher is
+  // running; the program id then changes at a ShaderWatcher::poll() while
+  // uniform handles stay valid.
+  // use/activate the shader, a no-op when it is already the bound program
   void use();
+  // bind program 0 if this program is bound. Not needed between Shaders,
+  // use() simply replaces the previous program.
   void disable();
+  // bind program 0, required before glUseProgram or glBindProgramPipeline
+  // by hand so the bind tracking stays in sync
+  static void unbind();
+
+  struct BindStats {
+    unsigned int issued{0};
+    unsigned int elided{0};
+  };
+  // glUseProgram calls issued and skipped since the last reset
+  static BindStats getBindStats();
+  static void resetBindStats();
+
+  // The setters keep a copy of the last value written to each uniform and
+  // skip the upload when it is unchanged. Only writes made while this
+  // program is bound, with the declared type and size, are remembered.
+  // Writing uniforms with raw glUniform* calls on getProgramId() bypasses
+  // that copy.
+  struct UploadStats {
+    unsigned int issued{0};
+    unsigned int skipped{0};
+  };
+  static UploadStats getUploadStats();
+  static void resetUploadStats();
+
+  // resolve a uniform once and keep the handle for hot loops
+  UniformHandle getUniformHandle(const std::string &name) const;
+  // typed uniforms, see Uniform.h. check() resolves them up front and
+  // reports declarations whose GLSL type doesn't match.
+  template <typename T>
+  void set(const Uniform<T> &uniform, T const &value) const {
+    upload(resolve(uniform), value);
+  }
+  template <typename... T> bool check(const Uniform<T> &...uniforms) const {
+    return (true & ... & (resolve(uniforms) != TYPE_MISMATCH));
+  }
   // utility uniform functions
   void setBool(const std::string &name, bool value) const;
   void setInt(const std::string &name, int value) const;
   void setFloat(const std::string &name, float value) const;
   void setVec3(const std::string &name,float x,float y, float z) const;
   void setVec3(const std::string &name, glm::vec3 const& vec3) const;
+  void setVec2(const std::string &name, glm::vec2 const &vec2) const;
+  void setVec4(const std::string &name, glm::vec4 const &vec4) const;
+  void setMat3f(const std::string &name, glm::mat3 const &mat) const;
   void setMat4f(const std::string &name,glm::mat4 const& mat) const;
+  void setBool(UniformHandle handle, bool value) const;
+  void setInt(UniformHandle handle, int value) const;
+  void setFloat(UniformHandle handle, float value) const;
+  void setVec3(UniformHandle handle, float x, float y, float z) const;
+  void setVec3(UniformHandle handle, glm::vec3 const &vec3) const;
+  void setVec2(UniformHandle handle, glm::vec2 const &vec2) const;
+  void setVec4(UniformHandle handle, glm::vec4 const &vec4) const;
+  void setMat3f(UniformHandle handle, glm::mat3 const &mat) const;
+  void setMat4f(UniformHandle handle, glm::mat4 const &mat) const;
+  // a batch of array elements in one call, starting at element 0 of the
+  // array `name` (or at the element the handle was resolved for)
+  void setMat4fArray(const std::string &name,
+                     std::span<const glm::mat4> values) const;
+  void setVec3Array(const std::string &name,
+                    std::span<const glm::vec3> values) const;
+  void setMat4fArray(UniformHandle handle,
+                     std::span<const glm::mat4> values) const;
+  void setVec3Array(UniformHandle handle,
+                    std::span<const glm::vec3> values) const;
+  // bind the uniform block `name` to a binding point (see UniformBlock),
+  // kept across rebuilds; false when the program has no such block
+  bool bindUniformBlock(const std::string &name, GLuint bindingPoint);
+  // same for a shader storage block (see StorageBuffer), needs GL 4.3
+  bool bindStorageBlock(const std::string &name, GLuint bindingPoint);
+
+  struct AttributeInfo {
+    std::string name;
+    GLint location{-1};
+    GLenum type{0};
+    GLint size{0};
+  };
+  // vertex inputs of the linked program, built-ins (gl_VertexID, ...) have
+  // location -1
+  const std::vector<AttributeInfo> &getActiveAttributes() const;
+  // compare the vertex inputs with a buffer layout and print every mismatch
+  bool validateLayout(const VertexLayout &layout) const;
+  bool validateVertexArray(unsigned int vao) const {
+    return validateLayout(vertexLayoutOf(vao));
+  }
+
   unsigned int getProgramId();
+
+  // where the time to build this program went, in milliseconds. Compile
+  // and link times are what the calling thread spent submitting the work
+  // and waiting for its status, so with parallel compilation they can add up
+  // to less than `totalMs`, the wall time from construction until the link
+  // was first seen finished.
+  struct BuildStats {
+    double readMs{0};
+    double vertexCompileMs{0};
+    double fragmentCompileMs{0};
+    double linkMs{0};
+    double totalMs{0};
+    bool fromBinaryCache{false};
+    GLint activeUniforms{0};
+    GLint activeAttributes{0};
+    // 0 where program binaries are unsupported
+    GLint binaryBytes{0};
+  };
+  // waits for the link
+  const BuildStats &getBuildStats() const;
+  // one line per live shader, slowest first, e.g. right after startup
+  static void printBuildReport();
   ~Shader();
 
 private:
+  friend class ShaderWatcher;
+  enum class State { Pending, Linked, Failed };
+
+  // a replacement program for ShaderWatcher
+  Shader(PreprocessedSource const &vertexCode,
+         PreprocessedSource const &fragmentCode);
+
   // the program ID
   unsigned int mId{std::numeric_limits<unsigned int>::max()};
+  // link results are collected lazily, see finish_link()
+  mutable State mState{State::Pending};
+  unsigned int mVertexShader{0};
+  unsigned int mFragmentShader{0};
+  mutable std::vector<std::pair<unsigned int, std::string>> mShaderNames;
+  uint64_t mBinaryKey{0};
+  // names not reported by glGetActiveUniform (e.g. "lights[2]") are added on
+  // first lookup, hence mutable
+  mutable UniformTable mUniforms;
+  // last uploaded value of each uniform, laid out by UniformInfo::shadowOffset
+  mutable std::vector<unsigned char> mShadow;
+  mutable std::vector<bool> mShadowWritten;
+  mutable std::vector<AttributeInfo> mAttributes;
+  std::vector<std::pair<std::string, GLuint>> mBlockBindings;
+  std::vector<std::pair<std::string, GLuint>> mStorageBindings;
+  // changes whenever mUniforms is rebuilt, invalidates Uniform<T> caches
+  mutable uint64_t mTableSerial{0};
+  ShaderSources mSources;
+  mutable BuildStats mBuildStats;
+  std::chrono::steady_clock::time_point mBuildStart;
+  // totalMs is taken once, the first time the link is seen finished
+  mutable bool mLinkTimed{false};
 
-  void read_shader_file(const char *vertexPath, const char *fragmentPath,
-                        std::string *vertexCode, std::string *fragCode);
-  unsigned int compile_shader(GLenum shaderType, const char *shaderCode,
+  void build(PreprocessedSource const &vertexCode,
+             PreprocessedSource const &fragmentCode);
+  // make the shader known to ShaderWatcher and the build report
+  void track(PreprocessedSource const &vertexCode,
+             PreprocessedSource const &fragmentCode);
+  void collect_stats() const;
+  void record_link_time() const;
+  // take over the program of a freshly linked rebuild of this shader
+  void adopt(Shader &next);
+  unsigned int compile_shader(GLenum shaderType,
+                              PreprocessedSource const &shaderCode,
                               std::string const &shader_name);
   unsigned int create_program(unsigned int vertexShader,
                               unsigned int fragementShader);
+  // whether linking is done (successfully or not), never blocks when the
+  // driver can report completion
+  bool link_finished() const;
+  void finish_link() const;
+  void load_uniforms(unsigned int program,
+                     const UniformTable *keep = nullptr) const;
+  void load_attributes(unsigned int program) const;
+  GLint location(UniformHandle handle) const;
+  bool needs_upload(UniformHandle handle, GLenum type, const void *data,
+                    size_t bytes) const;
+
+  static constexpr UniformHandle TYPE_MISMATCH = -2;
+  template <typename T> UniformHandle resolve(const Uniform<T> &uniform) const {
+    finish_link();
+    for (auto &cached : uniform.mCached)
+      if (cached.tableSerial == mTableSerial)
+        return cached.handle;
+    auto &slot = uniform.mCached[uniform.mNextSlot];
+    uniform.mNextSlot = (uniform.mNextSlot + 1) % uniform.mCached.size();
+    slot.handle = resolve(uniform.hash(), uniform.name(), Uniform<T>::glType);
+    slot.tableSerial = mTableSerial;
+    return slot.handle;
+  }
+  UniformHandle resolve(uint64_t hash, std::string_view name,
+                        GLenum type) const;
+  void upload(UniformHandle handle, bool value) const {
+    setBool(handle, value);
+  }
+  void upload(UniformHandle handle, int value) const { setInt(handle, value); }
+  void upload(UniformHandle handle, float value) const {
+    setFloat(handle, value);
+  }
+  void upload(UniformHandle handle, glm::vec2 const &value) const {
+    setVec2(handle, value);
+  }
+  void upload(UniformHandle handle, glm::vec3 const &value) const {
+    setVec3(handle, value);
+  }
+  void upload(UniformHandle handle, glm::vec4 const &value) const {
+    setVec4(handle, value);
+  }
+  void upload(UniformHandle handle, glm::mat3 const &value) const {
+    setMat3f(handle, value);
+  }
+  void upload(UniformHandle handle, glm::mat4 const &value) const {
+    setMat4f(handle, value);
+  }
 };
+
+// complete info logs, however long the driver's messages are
+std::string shaderInfoLog(unsigned int shader);
+std::string programInfoLog(unsigned int program);
@@ -0,0 +1,49 @@
+// Build-time shader check, run by compile_executable for every .sd file:
+//
+//   shader_check <input.sd> <stripped output> <expanded output>
+//
+// writes a comment and whitespace stripped copy of the file, which is what
+// gets embedded, and the same text with its #includes expanded for an
+// offline validator. Fails when the file or one of its includes can't be
+// read.
+#include "common/ShaderPreprocessor.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+bool write_file(const std::filesystem::path &path, const std::string &text) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file{path, std::ios::binary};
+  file << text;
+  if (!file) {
+    std::cout << "ERROR: SHADER::FILE_NOT_SUCCESFULLY_WRITTEN " << path
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 4) {
+    std::cout << "usage: " << argv[0]
+              << " <input.sd> <stripped output> <expanded output>"
+              << std::endl;
+    return 2;
+  }
+
+  MappedFile input{argv[1]};
+  if (!input.isOpen()) {
+    std::cout << "ERROR: SHADER::FILE_NOT_SUCCESFULLY_READ " << argv[1] << ": "
+              << input.error() << std::endl;
+    return 1;
+  }
+  auto expanded = ShaderPreprocessor::process(argv[1]);
+  if (!expanded.ok)
+    return 1;
+
+  bool ok = write_file(argv[2], stripShaderSource(input.view()));
+  ok = write_file(argv[3], stripShaderSource(expanded.str())) && ok;
+  return ok ? 0 : 1;
+}